@@ -0,0 +1,320 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "game.h"
+#include "session.h"
+#include "protocol.h"
+#include "http_server.h"
+#include "arena.h"
+
+#define TARGET_BENCH_NS 200000000LL
+#define LOOKUP_KEYS 65536
+
+/*
+    One line per benchmark, key=value pairs, so two runs can be diffed.
+    Allocations are counted by interposing the malloc family, which also
+    catches the allocations made inside jansson.
+*/
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static uint64_t alloc_count;
+
+void* malloc(size_t size) {
+    alloc_count++;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    alloc_count++;
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void *ptr, size_t size) {
+    alloc_count++;
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) {
+    __libc_free(ptr);
+}
+
+typedef void (*bench_fn)(void *state, long ops);
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ull;
+
+static inline uint32_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)(rng_state >> 32);
+}
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Doubles the op count until one run takes TARGET_BENCH_NS, then reports it.
+static void run_bench(const char *name, bench_fn fn, void *state) {
+    long ops = 1;
+
+    for (;;) {
+        uint64_t allocs_before = alloc_count;
+        int64_t start = now_ns();
+        fn(state, ops);
+        int64_t elapsed = now_ns() - start;
+        uint64_t allocs = alloc_count - allocs_before;
+
+        if (elapsed >= TARGET_BENCH_NS || ops >= (1L << 30)) {
+            printf("bench=%s ops=%ld ns_per_op=%.1f allocs_per_op=%.2f\n",
+                name, ops, (double)elapsed / ops, (double)allocs / ops);
+            return;
+        }
+
+        ops *= 2;
+    }
+}
+
+
+
+static void bench_serialize_board(void *state, long ops) {
+    const Board *board = state;
+    for (long i = 0; i < ops; i++) {
+        json_t *board_json = serialize_board(board);
+        json_decref(board_json);
+    }
+}
+
+static void bench_game_state_message(void *state, long ops) {
+    const GameSession *session = state;
+    for (long i = 0; i < ops; i++) {
+        char *message = build_game_state_message(session, 1 + (int)(i & 1));
+        free(message);
+    }
+}
+
+typedef struct {
+    SessionStore store;
+    SessionId keys[LOOKUP_KEYS];
+} LookupState;
+
+static void bench_find_session(void *state, long ops) {
+    LookupState *lookup = state;
+    uintptr_t found = 0;
+    for (long i = 0; i < ops; i++) {
+        found += (uintptr_t)find_session(&lookup->store, lookup->keys[i & (LOOKUP_KEYS - 1)]);
+    }
+    __asm__ volatile("" : : "r"(found));
+}
+
+static void bench_setup_random_board(void *state, long ops) {
+    const GameVariant *variant = state;
+    Board board;
+    for (long i = 0; i < ops; i++) {
+        setup_random_board(&board, variant);
+    }
+    __asm__ volatile("" : : "r"(&board) : "memory");
+}
+
+typedef struct {
+    Board board;
+    uint8_t shots[MAX_BOARD_SIZE * MAX_BOARD_SIZE];
+    int cell_count;
+} ShotState;
+
+// Fires at every cell in shuffled order; the board is reset once per pass.
+static void bench_check_hit(void *state, long ops) {
+    ShotState *shot_state = state;
+    Board board = shot_state->board;
+    int n = shot_state->board.size;
+    int hits = 0;
+
+    for (long i = 0; i < ops; i++) {
+        int cell = (int)(i % shot_state->cell_count);
+        if (cell == 0) board = shot_state->board;
+        hits += check_hit(&board, shot_state->shots[cell] % n, shot_state->shots[cell] / n);
+    }
+    __asm__ volatile("" : : "r"(hits));
+}
+
+static void bench_generate_session_id(void *state, long ops) {
+    (void)state;
+    char id_str[SESSION_ID_STR_LEN];
+    for (long i = 0; i < ops; i++) {
+        SessionId id;
+        fill_random(&id, sizeof(id));
+        format_session_id(id, id_str);
+    }
+    __asm__ volatile("" : : "r"(id_str) : "memory");
+}
+
+typedef struct {
+    char body[MHD_MAX_JSON_SIZE];
+    size_t body_size;
+    size_t chunk_size;
+} UploadState;
+
+// Mirrors http_handler: allocate the context, append each chunk, release.
+static void bench_http_body(void *state, long ops) {
+    UploadState *upload = state;
+    for (long i = 0; i < ops; i++) {
+        struct connection_info *con_info = connection_info_create(0);
+        for (size_t off = 0; off < upload->body_size; off += upload->chunk_size) {
+            size_t size = upload->body_size - off < upload->chunk_size ? upload->body_size - off : upload->chunk_size;
+            connection_info_append(con_info, upload->body + off, size);
+        }
+        connection_info_free(con_info);
+    }
+}
+
+
+// Both run build_game_state_message; the arena one the way ws_server does.
+static void bench_game_state_message_arena(void *state, long ops) {
+    const GameSession *session = state;
+    static _Alignas(ARENA_ALIGN) unsigned char initial[16384];
+    Arena arena;
+    arena_init(&arena, initial, sizeof(initial));
+
+    Arena *previous = arena_enter(&arena);
+    for (long i = 0; i < ops; i++) {
+        char *message = build_game_state_message(session, 1 + (int)(i & 1));
+        free(message);
+        arena_reset(&arena);
+    }
+    arena_leave(previous);
+}
+
+static const char create_body[] = "{\"player_name\":\"player1\",\"variant\":\"classic\"}";
+
+// A /create request end to end, minus MHD: body, parse, response, release.
+static void bench_http_create(void *state, long ops) {
+    const GameSession *session = state;
+    for (long i = 0; i < ops; i++) {
+        struct connection_info *con_info = connection_info_create(sizeof(create_body) - 1);
+        connection_info_append(con_info, create_body, sizeof(create_body) - 1);
+
+        Arena *previous = arena_enter(&con_info->arena);
+
+        json_t *root = json_loadb(con_info->upload_data, con_info->upload_data_size, 0, NULL);
+        json_t *response = json_object();
+        json_object_set_new(response, "player", json_string(json_string_value(json_object_get(root, "player_name"))));
+        json_object_set_new(response, "board", serialize_board(&session->board1));
+
+        char *response_str = dump_json(response);
+        json_decref(response);
+        json_decref(root);
+
+        arena_leave(previous);
+        connection_info_free(con_info);
+        free(response_str);
+    }
+}
+
+
+
+static void play_some_moves(GameSession *session, int moves) {
+    for (int i = 0; i < moves && session->state == IN_PROGRESS; i++) {
+        int n = session->board1.size;
+        apply_attack(session, next_random() % n, next_random() % n);
+    }
+}
+
+static int run_find_session(int session_count) {
+    LookupState *lookup = malloc(sizeof(LookupState));
+    if (!lookup || !session_store_init(&lookup->store, session_count)) {
+        fprintf(stderr, "cannot allocate %d sessions\n", session_count);
+        free(lookup);
+        return 1;
+    }
+
+    for (int i = 0; i < session_count; i++) {
+        create_session(&lookup->store, "player1", VARIANT_CLASSIC);
+    }
+    for (int i = 0; i < LOOKUP_KEYS; i++) {
+        lookup->keys[i] = lookup->store.infos[next_random() % (uint32_t)session_count].id;
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "find_session/%d", session_count);
+    run_bench(name, bench_find_session, lookup);
+
+    session_store_destroy(&lookup->store);
+    free(lookup);
+    return 0;
+}
+
+int main(void) {
+    game_seed_random(1);
+    arena_install_json_hooks();
+
+    for (int v = 0; v < VARIANT_COUNT; v++) {
+        const GameVariant *variant = &game_variants[v];
+        char name[64];
+
+        GameSession session;
+        memset(&session, 0, sizeof(session));
+        setup_random_board(&session.board1, variant);
+        setup_random_board(&session.board2, variant);
+        session.state = IN_PROGRESS;
+        session.current_player = 1;
+        play_some_moves(&session, variant->board_size * variant->board_size);
+
+        snprintf(name, sizeof(name), "serialize_board/%s", variant->name);
+        run_bench(name, bench_serialize_board, &session.board1);
+
+        snprintf(name, sizeof(name), "game_state_message/%s", variant->name);
+        run_bench(name, bench_game_state_message, &session);
+
+        snprintf(name, sizeof(name), "game_state_message_arena/%s", variant->name);
+        run_bench(name, bench_game_state_message_arena, &session);
+
+        snprintf(name, sizeof(name), "http_create/%s", variant->name);
+        run_bench(name, bench_http_create, &session);
+
+        snprintf(name, sizeof(name), "setup_random_board/%s", variant->name);
+        run_bench(name, bench_setup_random_board, (void *)variant);
+
+        ShotState shot_state;
+        setup_random_board(&shot_state.board, variant);
+        shot_state.cell_count = variant->board_size * variant->board_size;
+        for (int i = 0; i < shot_state.cell_count; i++) {
+            shot_state.shots[i] = (uint8_t)i;
+        }
+        for (int i = shot_state.cell_count - 1; i > 0; i--) {
+            int j = next_random() % (uint32_t)(i + 1);
+            uint8_t tmp = shot_state.shots[i];
+            shot_state.shots[i] = shot_state.shots[j];
+            shot_state.shots[j] = tmp;
+        }
+
+        snprintf(name, sizeof(name), "check_hit/%s", variant->name);
+        run_bench(name, bench_check_hit, &shot_state);
+    }
+
+    if (run_find_session(100)) return 1;
+    if (run_find_session(10000)) return 1;
+    if (run_find_session(100000)) return 1;
+
+    run_bench("generate_session_id", bench_generate_session_id, NULL);
+
+    static UploadState upload;
+    memset(upload.body, 'x', sizeof(upload.body));
+
+    upload.body_size = 256;
+    upload.chunk_size = 256;
+    run_bench("http_body/256x1", bench_http_body, &upload);
+
+    upload.body_size = MHD_MAX_JSON_SIZE;
+    upload.chunk_size = 1024;
+    run_bench("http_body/1024x4", bench_http_body, &upload);
+
+    return 0;
+}
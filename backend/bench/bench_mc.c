@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "game.h"
+#include "bot.h"
+#include "bot_mc.h"
+#include "worker_pool.h"
+
+#define DEFAULT_POSITIONS 20
+#define OPENING_SHOTS 30
+#define QUALITY_GAMES 100
+#define QUALITY_SEED 7
+#define QUALITY_BUDGET_US 5000
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    MonteCarloSearch *search;
+} SearchWaiter;
+
+static SearchWaiter waiter = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL};
+
+static void on_done(MonteCarloSearch *search) {
+    pthread_mutex_lock(&waiter.mutex);
+    waiter.search = search;
+    pthread_cond_signal(&waiter.cond);
+    pthread_mutex_unlock(&waiter.mutex);
+}
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static MonteCarloSearch* search_blocking(WorkerPool *pool, const Board *board, int budget_us) {
+    MonteCarloSearch *search = mc_search_create(board);
+    if (!search) return NULL;
+
+    mc_search_submit(pool, search, budget_us, on_done);
+
+    pthread_mutex_lock(&waiter.mutex);
+    while (!waiter.search) {
+        pthread_cond_wait(&waiter.cond, &waiter.mutex);
+    }
+    waiter.search = NULL;
+    pthread_mutex_unlock(&waiter.mutex);
+
+    return search;
+}
+
+// A classic board part-way through a game, so samples have hits to honour.
+static void setup_position(Board *board) {
+    setup_random_board(board, &game_variants[VARIANT_CLASSIC]);
+
+    for (int i = 0; i < OPENING_SHOTS && !is_game_over(board); i++) {
+        int x, y;
+        if (!bot_choose_shot(board, &x, &y)) break;
+        if (check_hit(board, x, y)) {
+            int sunk = is_ship_sunk(board, x, y);
+            if (sunk != -1) sunk_the_ship(board, sunk);
+        }
+    }
+}
+
+static int run_scaling(int threads, int positions) {
+    WorkerPool *pool = worker_pool_create(threads);
+    if (!pool) {
+        fprintf(stderr, "cannot start %d workers\n", threads);
+        return 1;
+    }
+
+    game_seed_random(1);
+    uint64_t samples = 0;
+    int64_t search_ns = 0;
+
+    for (int i = 0; i < positions; i++) {
+        Board board;
+        setup_position(&board);
+
+        int64_t start = now_ns();
+        MonteCarloSearch *search = search_blocking(pool, &board, MC_BOT_BUDGET_US);
+        search_ns += now_ns() - start;
+        if (!search) break;
+        samples += search->samples;
+        free(search);
+    }
+
+    double elapsed = search_ns / 1e9;
+    printf("threads=%d positions=%d budget_us=%d samples_per_move=%.0f samples_per_sec=%.0f\n",
+        threads, positions, MC_BOT_BUDGET_US, (double)samples / positions, samples / elapsed);
+
+    worker_pool_destroy(pool);
+    return 0;
+}
+
+static int mc_shot(WorkerPool *pool, const Board *board, int *x, int *y) {
+    MonteCarloSearch *search = search_blocking(pool, board, QUALITY_BUDGET_US);
+    if (!search) return 0;
+
+    *x = search->x;
+    *y = search->y;
+    free(search);
+    return *x >= 0;
+}
+
+/*
+    Plays one game with either bot. While the density bot plays, the Monte
+    Carlo bot is also asked for its shot at every position, and hits[0] and
+    hits[1] count how often each choice lands on a ship. Comparing choices
+    on the same positions shows a difference that whole-game averages hide
+    in their variance.
+*/
+static int play_game(WorkerPool *pool, int use_mc, long hits[2]) {
+    Board board;
+    setup_random_board(&board, &game_variants[VARIANT_CLASSIC]);
+
+    int shots = 0;
+    while (!is_game_over(&board)) {
+        int x, y;
+
+        if (use_mc) {
+            if (!mc_shot(pool, &board, &x, &y)) return -1;
+        } else {
+            int mc_x, mc_y;
+            if (!bot_choose_shot(&board, &x, &y)) return -1;
+            if (!mc_shot(pool, &board, &mc_x, &mc_y)) return -1;
+
+            hits[0] += board_cell(&board, x, y) == SHIP;
+            hits[1] += board_cell(&board, mc_x, mc_y) == SHIP;
+        }
+
+        shots++;
+        if (check_hit(&board, x, y)) {
+            int sunk = is_ship_sunk(&board, x, y);
+            if (sunk != -1) sunk_the_ship(&board, sunk);
+        }
+    }
+
+    return shots;
+}
+
+/*
+    Both bots play the same QUALITY_GAMES boards. Returns 1 when the Monte
+    Carlo bot's shots hit less often than the density bot's on the same
+    positions, since then the hard bot is not worth its CPU time. Whole
+    games only warn: a one-shot difference is within their noise.
+*/
+static int run_quality(int threads) {
+    WorkerPool *pool = worker_pool_create(threads);
+    if (!pool) return 1;
+
+    double avg_shots[2];
+    long hits[2] = {0, 0};
+    long positions = 0;
+
+    for (int use_mc = 0; use_mc <= 1; use_mc++) {
+        long shots = 0;
+        for (int i = 0; i < QUALITY_GAMES; i++) {
+            game_seed_random(QUALITY_SEED + i);
+            int game_shots = play_game(pool, use_mc, hits);
+            if (game_shots < 0) {
+                fprintf(stderr, "bot=%s gave up on game %d\n", use_mc ? "monte_carlo" : "density", i);
+                worker_pool_destroy(pool);
+                return 1;
+            }
+            shots += game_shots;
+        }
+        if (!use_mc) positions = shots;
+        avg_shots[use_mc] = (double)shots / QUALITY_GAMES;
+        printf("  bot=%s games=%d budget_us=%d avg_shots=%.2f\n", use_mc ? "monte_carlo" : "density",
+            QUALITY_GAMES, QUALITY_BUDGET_US, avg_shots[use_mc]);
+    }
+
+    worker_pool_destroy(pool);
+
+    printf("  positions=%ld density_hit_rate=%.3f monte_carlo_hit_rate=%.3f\n",
+        positions, (double)hits[0] / positions, (double)hits[1] / positions);
+
+    if (avg_shots[1] >= avg_shots[0]) {
+        fprintf(stderr, "warning: monte_carlo bot needed %.2f shots per game, density %.2f\n",
+            avg_shots[1], avg_shots[0]);
+    }
+    if (hits[1] <= hits[0]) {
+        fprintf(stderr, "monte_carlo bot is not stronger than density: %ld <= %ld hits on %ld positions\n",
+            hits[1], hits[0], positions);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int positions = (argc > 1) ? atoi(argv[1]) : DEFAULT_POSITIONS;
+    long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpu_count < 1) cpu_count = 1;
+
+    for (int threads = 1; threads < cpu_count; threads *= 2) {
+        if (run_scaling(threads, positions)) return 1;
+    }
+    if (run_scaling((int)cpu_count, positions)) return 1;
+
+    return run_quality((int)cpu_count);
+}
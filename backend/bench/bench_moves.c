@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "game.h"
+#include "session.h"
+
+#define DEFAULT_MOVES 5000000
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ull;
+
+static inline uint32_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)(rng_state >> 32);
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void restart_session(GameSession *session) {
+    const GameVariant *variant = &game_variants[session->variant];
+    setup_random_board(&session->board1, variant);
+    setup_random_board(&session->board2, variant);
+    session->state = IN_PROGRESS;
+    session->current_player = 1;
+}
+
+static int run(int session_count, long moves) {
+    SessionStore store;
+    if (!session_store_init(&store, session_count)) {
+        fprintf(stderr, "cannot allocate %d sessions\n", session_count);
+        return 1;
+    }
+
+    for (int i = 0; i < session_count; i++) {
+        GameSession *session = create_session(&store, "player1", VARIANT_CLASSIC);
+        if (!session || !join_session(&store, session, "player2")) {
+            fprintf(stderr, "cannot create session %d\n", i);
+            session_store_destroy(&store);
+            return 1;
+        }
+    }
+
+    long finished = 0;
+    double start = now_seconds();
+
+    for (long i = 0; i < moves; i++) {
+        uint32_t r = next_random();
+        GameSession *session = &store.sessions[r % (uint32_t)session_count];
+
+        if (session->state != IN_PROGRESS) {
+            restart_session(session);
+        }
+
+        int board_size = session->board1.size;
+        int x = (r >> 8) % board_size;
+        int y = (r >> 16) % board_size;
+        finished += apply_attack(session, x, y);
+    }
+
+    double elapsed = now_seconds() - start;
+
+    printf("sessions=%d moves=%ld games_finished=%ld elapsed_s=%.3f moves_per_sec=%.0f ns_per_move=%.1f\n",
+        session_count, moves, finished, elapsed, moves / elapsed, elapsed * 1e9 / moves);
+    printf("  sizeof(GameSession)=%zu sizeof(Board)=%zu sizeof(SessionInfo)=%zu dilate=%s\n",
+        sizeof(GameSession), sizeof(Board), sizeof(SessionInfo), dilate_rows_impl_name());
+
+    session_store_destroy(&store);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    long moves = (argc > 1) ? atol(argv[1]) : DEFAULT_MOVES;
+
+    game_seed_random(1);
+
+    if (run(10000, moves)) return 1;
+    if (run(100000, moves)) return 1;
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <jansson.h>
+
+#include "arena.h"
+
+// Prefix of every jansson allocation, so json_free knows where it came from.
+typedef struct {
+    _Alignas(ARENA_ALIGN) size_t from_arena;
+} JsonAllocHeader;
+
+_Thread_local Arena *arena_current;
+
+
+
+static inline size_t align_up(size_t size) {
+    return (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+void arena_init(Arena *arena, void *initial, size_t initial_size) {
+    uintptr_t start = ((uintptr_t)initial + ARENA_ALIGN - 1) & ~(uintptr_t)(ARENA_ALIGN - 1);
+    size_t skipped = (size_t)(start - (uintptr_t)initial);
+
+    arena->initial = (unsigned char *)start;
+    arena->initial_size = initial_size > skipped ? initial_size - skipped : 0;
+    arena->ptr = arena->initial;
+    arena->end = arena->initial + arena->initial_size;
+    arena->last = NULL;
+    arena->blocks = NULL;
+}
+
+void* arena_alloc(Arena *arena, size_t size) {
+    size = align_up(size ? size : 1);
+
+    if ((size_t)(arena->end - arena->ptr) < size) {
+        size_t block_size = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        ArenaBlock *block = malloc(sizeof(ArenaBlock) + block_size);
+        if (!block) return NULL;
+
+        block->next = arena->blocks;
+        arena->blocks = block;
+        arena->ptr = block->data;
+        arena->end = block->data + block_size;
+    }
+
+    arena->last = arena->ptr;
+    arena->ptr += size;
+    return arena->last;
+}
+
+void* arena_grow(Arena *arena, void *ptr, size_t old_size, size_t new_size) {
+    if (ptr && ptr == arena->last && (size_t)(arena->end - arena->last) >= align_up(new_size)) {
+        arena->ptr = arena->last + align_up(new_size);
+        return ptr;
+    }
+
+    void *grown = arena_alloc(arena, new_size);
+    if (grown && ptr) {
+        memcpy(grown, ptr, old_size < new_size ? old_size : new_size);
+    }
+    return grown;
+}
+
+void arena_reset(Arena *arena) {
+    while (arena->blocks) {
+        ArenaBlock *next = arena->blocks->next;
+        free(arena->blocks);
+        arena->blocks = next;
+    }
+
+    arena->ptr = arena->initial;
+    arena->end = arena->initial + arena->initial_size;
+    arena->last = NULL;
+}
+
+
+
+static void* json_arena_malloc(size_t size) {
+    JsonAllocHeader *header;
+
+    if (arena_current) {
+        header = arena_alloc(arena_current, sizeof(JsonAllocHeader) + size);
+    } else {
+        header = malloc(sizeof(JsonAllocHeader) + size);
+    }
+    if (!header) return NULL;
+
+    header->from_arena = arena_current != NULL;
+    return header + 1;
+}
+
+static void json_arena_free(void *ptr) {
+    if (!ptr) return;
+
+    JsonAllocHeader *header = (JsonAllocHeader *)ptr - 1;
+    if (!header->from_arena) {
+        free(header);
+    }
+}
+
+// Must run before any JSON is created; jansson's hooks are process-wide.
+void arena_install_json_hooks(void) {
+    json_set_alloc_funcs(json_arena_malloc, json_arena_free);
+}
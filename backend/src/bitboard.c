@@ -0,0 +1,89 @@
+#include "bitboard.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+dilate_rows_fn dilate_rows = dilate_rows_scalar;
+
+void dilate_rows_scalar(const BoardRow *rows, const BoardRow *mask, BoardRow *out) {
+    BoardRow grown[BOARD_ROWS];
+
+    for (int y = 0; y < BOARD_ROWS; y++) {
+        grown[y] = rows[y] | (BoardRow)(rows[y] << 1) | (BoardRow)(rows[y] >> 1);
+    }
+
+    for (int y = 0; y < BOARD_ROWS; y++) {
+        BoardRow above = (y > 0) ? grown[y - 1] : 0;
+        BoardRow below = (y < BOARD_ROWS - 1) ? grown[y + 1] : 0;
+        out[y] = (grown[y] | above | below) & mask[y];
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("sse2")))
+void dilate_rows_sse2(const BoardRow *rows, const BoardRow *mask, BoardRow *out) {
+    __m128i lo = _mm_loadu_si128((const __m128i *)rows);
+    __m128i hi = _mm_loadu_si128((const __m128i *)(rows + 8));
+
+    lo = _mm_or_si128(lo, _mm_or_si128(_mm_slli_epi16(lo, 1), _mm_srli_epi16(lo, 1)));
+    hi = _mm_or_si128(hi, _mm_or_si128(_mm_slli_epi16(hi, 1), _mm_srli_epi16(hi, 1)));
+
+    // row y takes row y - 1
+    __m128i down_lo = _mm_slli_si128(lo, 2);
+    __m128i down_hi = _mm_or_si128(_mm_slli_si128(hi, 2), _mm_srli_si128(lo, 14));
+
+    // row y takes row y + 1
+    __m128i up_lo = _mm_or_si128(_mm_srli_si128(lo, 2), _mm_slli_si128(hi, 14));
+    __m128i up_hi = _mm_srli_si128(hi, 2);
+
+    lo = _mm_or_si128(lo, _mm_or_si128(down_lo, up_lo));
+    hi = _mm_or_si128(hi, _mm_or_si128(down_hi, up_hi));
+
+    lo = _mm_and_si128(lo, _mm_loadu_si128((const __m128i *)mask));
+    hi = _mm_and_si128(hi, _mm_loadu_si128((const __m128i *)(mask + 8)));
+
+    _mm_storeu_si128((__m128i *)out, lo);
+    _mm_storeu_si128((__m128i *)(out + 8), hi);
+}
+
+__attribute__((target("avx2")))
+void dilate_rows_avx2(const BoardRow *rows, const BoardRow *mask, BoardRow *out) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)rows);
+
+    v = _mm256_or_si256(v, _mm256_or_si256(_mm256_slli_epi16(v, 1), _mm256_srli_epi16(v, 1)));
+
+    // Shift the 16 rows by one across the lane boundary: permute brings the
+    // neighbouring lane in, alignr moves every row by two bytes.
+    __m256i low_to_high = _mm256_permute2x128_si256(v, v, 0x08);
+    __m256i high_to_low = _mm256_permute2x128_si256(v, v, 0x81);
+    __m256i down = _mm256_alignr_epi8(v, low_to_high, 14);
+    __m256i up = _mm256_alignr_epi8(high_to_low, v, 2);
+
+    v = _mm256_or_si256(v, _mm256_or_si256(down, up));
+    v = _mm256_and_si256(v, _mm256_loadu_si256((const __m256i *)mask));
+
+    _mm256_storeu_si256((__m256i *)out, v);
+}
+
+__attribute__((constructor))
+static void select_dilate_rows(void) {
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) {
+        dilate_rows = dilate_rows_avx2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        dilate_rows = dilate_rows_sse2;
+    }
+}
+
+#endif
+
+const char* dilate_rows_impl_name(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (dilate_rows == dilate_rows_avx2) return "avx2";
+    if (dilate_rows == dilate_rows_sse2) return "sse2";
+#endif
+    return "scalar";
+}
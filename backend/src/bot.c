@@ -0,0 +1,204 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "bot.h"
+
+/*
+    Placement counts are kept as bit-sliced counters: planes[p][y] holds bit p
+    of the count for every cell of row y, so adding a whole row of placements
+    is a ripple-carry over the planes. Placements that run through an
+    unresolved hit are added at TARGET_WEIGHT_SHIFT so they always outrank
+    open-water placements.
+*/
+#define COUNTER_PLANES 16
+#define TARGET_WEIGHT_SHIFT 7
+
+static void add_placements(BoardRow planes[COUNTER_PLANES][BOARD_ROWS], int y, BoardRow cells, int shift) {
+    BoardRow carry = cells;
+
+    for (int p = shift; carry && p < COUNTER_PLANES; p++) {
+        BoardRow overflow = planes[p][y] & carry;
+        planes[p][y] ^= carry;
+        carry = overflow;
+    }
+}
+
+static void add_run(BoardRow planes[COUNTER_PLANES][BOARD_ROWS], int y, BoardRow open, BoardRow target) {
+    if (open) add_placements(planes, y, open, 0);
+    if (target) add_placements(planes, y, target, TARGET_WEIGHT_SHIFT);
+}
+
+void bot_observe(const Board *board, BotView *view) {
+    int n = board->size;
+    BoardRow board_mask = (BoardRow)((1u << n) - 1);
+    BoardRow sunk[BOARD_ROWS] = {0};
+
+    memset(view, 0, sizeof(BotView));
+    view->size = n;
+
+    for (int i = 0; i < board->ship_count; i++) {
+        const Ship *ship = &board->ships[i];
+
+        if (ship_hits(board, ship) < ship->size) {
+            view->fleet[view->fleet_size++] = ship->size;
+            continue;
+        }
+
+        if (ship->is_horizontal) {
+            sunk[ship->y] |= (BoardRow)(((1u << ship->size) - 1) << ship->x);
+        } else {
+            for (int j = 0; j < ship->size; j++) {
+                sunk[ship->y + j] |= (BoardRow)(1u << ship->x);
+            }
+        }
+    }
+
+    for (int i = 1; i < view->fleet_size; i++) {
+        uint8_t size = view->fleet[i];
+        int j = i;
+        for (; j > 0 && view->fleet[j - 1] < size; j--) {
+            view->fleet[j] = view->fleet[j - 1];
+        }
+        view->fleet[j] = size;
+    }
+
+    // Only what the shooter has seen: misses, hits, and ships already sunk.
+    for (int row = 0; row < n; row++) {
+        BoardRow shot = board->shot_rows[row];
+        BoardRow misses = shot & (BoardRow)~board->ship_rows[row];
+
+        view->open_hits[row] = shot & board->ship_rows[row] & (BoardRow)~sunk[row];
+        view->free_cells[row] = board_mask & (BoardRow)~(misses | sunk[row]);
+        view->unshot[row] = board_mask & (BoardRow)~shot;
+    }
+
+    // Ships are straight and never touch, so nothing sits diagonal to a hit.
+    for (int row = 0; row < n; row++) {
+        BoardRow around = ((row > 0) ? view->open_hits[row - 1] : 0) | ((row + 1 < n) ? view->open_hits[row + 1] : 0);
+        view->free_cells[row] &= (BoardRow)~((BoardRow)(around << 1) | (BoardRow)(around >> 1));
+    }
+}
+
+int bot_choose_density_shot(const BotView *view, int *x, int *y) {
+    int n = view->size;
+    const BoardRow *free_cells = view->free_cells;
+    const BoardRow *open_hits = view->open_hits;
+    const BoardRow *unshot = view->unshot;
+    const uint8_t *fleet = view->fleet;
+    int fleet_size = view->fleet_size;
+
+    BoardRow planes[COUNTER_PLANES][BOARD_ROWS];
+    memset(planes, 0, sizeof(planes));
+
+    for (int i = 0; i < fleet_size; i++) {
+        int size = fleet[i];
+
+        for (int row = 0; row < n; row++) {
+            BoardRow starts = free_cells[row];
+            BoardRow through_hit = open_hits[row];
+
+            for (int k = 1; k < size; k++) {
+                starts &= free_cells[row] >> k;
+                through_hit |= open_hits[row] >> k;
+            }
+            if (!starts) continue;
+
+            BoardRow target = starts & through_hit;
+            BoardRow open = starts & (BoardRow)~through_hit;
+
+            for (int k = 0; k < size; k++) {
+                add_run(planes, row, (BoardRow)(open << k), (BoardRow)(target << k));
+            }
+        }
+
+        if (size == 1) continue;
+
+        for (int row = 0; row + size <= n; row++) {
+            BoardRow starts = free_cells[row];
+            BoardRow through_hit = open_hits[row];
+
+            for (int k = 1; k < size; k++) {
+                starts &= free_cells[row + k];
+                through_hit |= open_hits[row + k];
+            }
+            if (!starts) continue;
+
+            BoardRow target = starts & through_hit;
+            BoardRow open = starts & (BoardRow)~through_hit;
+
+            for (int k = 0; k < size; k++) {
+                add_run(planes, row + k, open, target);
+            }
+        }
+    }
+
+    // Narrow the unshot cells down to those with the highest count, plane by plane.
+    BoardRow best[BOARD_ROWS];
+    memcpy(best, unshot, sizeof(best));
+
+    for (int p = COUNTER_PLANES - 1; p >= 0; p--) {
+        BoardRow narrowed[BOARD_ROWS];
+        BoardRow any = 0;
+
+        for (int row = 0; row < n; row++) {
+            narrowed[row] = best[row] & planes[p][row];
+            any |= narrowed[row];
+        }
+        if (any) {
+            memcpy(best, narrowed, sizeof(BoardRow) * n);
+        }
+    }
+
+    int candidates = 0;
+    for (int row = 0; row < n; row++) {
+        candidates += __builtin_popcount(best[row]);
+    }
+    if (candidates == 0) return 0;
+
+    int pick = (int)(game_random() % (uint32_t)candidates);
+    for (int row = 0; row < n; row++) {
+        int count = __builtin_popcount(best[row]);
+        if (pick < count) {
+            BoardRow bits = best[row];
+            while (pick--) bits &= bits - 1;
+
+            *x = __builtin_ctz(bits);
+            *y = row;
+            return 1;
+        }
+        pick -= count;
+    }
+
+    return 0;
+}
+
+int bot_choose_shot(const Board *board, int *x, int *y) {
+    BotView view;
+    bot_observe(board, &view);
+
+    return bot_choose_density_shot(&view, x, y);
+}
+
+int attach_bot(SessionStore *store, GameSession *session, BotKind kind) {
+    if (!join_session(store, session, BOT_PLAYER_NAME)) {
+        return 0;
+    }
+
+    session->bot = kind;
+    return 1;
+}
+
+int play_bot_turn(GameSession *session) {
+    while (session->state == IN_PROGRESS && session->current_player == 2) {
+        int x, y;
+
+        if (!bot_choose_shot(&session->board1, &x, &y)) {
+            break;
+        }
+        if (apply_attack(session, x, y)) {
+            return 1;
+        }
+    }
+
+    return session->state == FINISHED;
+}
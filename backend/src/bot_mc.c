@@ -0,0 +1,311 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bot_mc.h"
+
+#define DEADLINE_CHECK_INTERVAL 16
+
+static int64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static inline uint64_t next_random(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+#define MAX_HIT_PLACEMENTS (MAX_SHIPS * 2 * MAX_BOARD_SIZE)
+
+typedef struct {
+    uint8_t ship;
+    uint8_t x;
+    uint8_t y;
+    uint8_t is_horizontal;
+} Placement;
+
+static int placement_open(const BotView *view, const BoardRow *blocked, int size, int x, int y, int is_horizontal) {
+    int n = view->size;
+
+    if (x < 0 || y < 0) return 0;
+
+    if (is_horizontal) {
+        if (x + size > n) return 0;
+        BoardRow bits = (BoardRow)(((1u << size) - 1) << x);
+        return (view->free_cells[y] & (BoardRow)~blocked[y] & bits) == bits;
+    }
+
+    if (y + size > n) return 0;
+    for (int k = 0; k < size; k++) {
+        if (!((view->free_cells[y + k] & (BoardRow)~blocked[y + k]) >> x & 1)) return 0;
+    }
+    return 1;
+}
+
+static void add_ship(BoardRow *fleet_rows, int size, int x, int y, int is_horizontal) {
+    if (is_horizontal) {
+        fleet_rows[y] |= (BoardRow)(((1u << size) - 1) << x);
+    } else {
+        for (int k = 0; k < size; k++) {
+            fleet_rows[y + k] |= (BoardRow)(1u << x);
+        }
+    }
+}
+
+/*
+    Puts an unplaced ship over the first hit no ship covers yet, chosen
+    uniformly among the open placements through that hit. Returns 0 if
+    there is none.
+*/
+static int cover_hit(const BotView *view, const BoardRow *blocked, const uint8_t *placed, int hit_x, int hit_y, uint64_t *rng, Placement *chosen) {
+    Placement options[MAX_HIT_PLACEMENTS];
+    int count = 0;
+
+    for (int i = 0; i < view->fleet_size; i++) {
+        if (placed[i]) continue;
+        int size = view->fleet[i];
+
+        for (int k = 0; k < size; k++) {
+            if (placement_open(view, blocked, size, hit_x - k, hit_y, 1)) {
+                options[count++] = (Placement){(uint8_t)i, (uint8_t)(hit_x - k), (uint8_t)hit_y, 1};
+            }
+            if (size > 1 && placement_open(view, blocked, size, hit_x, hit_y - k, 0)) {
+                options[count++] = (Placement){(uint8_t)i, (uint8_t)hit_x, (uint8_t)(hit_y - k), 0};
+            }
+        }
+    }
+
+    if (count == 0) return 0;
+
+    *chosen = options[next_random(rng) % (uint64_t)count];
+    return 1;
+}
+
+/*
+    Samples where the rest of the fleet could be. Ships go over the open
+    hits first, so almost every sample honours them; the remaining ships
+    are then placed one at a time, uniformly among the placements still
+    open for each. The sample counts only if it covers every open hit.
+    Returns 1 and fills fleet_rows on success.
+*/
+static int sample_fleet(const BotView *view, const BoardRow *board_mask, uint64_t *rng, BoardRow *fleet_rows) {
+    int n = view->size;
+    _Alignas(32) BoardRow blocked[BOARD_ROWS];
+    uint8_t placed[MAX_SHIPS] = {0};
+
+    memset(fleet_rows, 0, sizeof(BoardRow) * BOARD_ROWS);
+    memset(blocked, 0, sizeof(blocked));
+
+    for (int row = 0; row < n; row++) {
+        BoardRow uncovered;
+        while ((uncovered = view->open_hits[row] & (BoardRow)~fleet_rows[row])) {
+            Placement chosen;
+            if (!cover_hit(view, blocked, placed, __builtin_ctz(uncovered), row, rng, &chosen)) return 0;
+
+            placed[chosen.ship] = 1;
+            add_ship(fleet_rows, view->fleet[chosen.ship], chosen.x, chosen.y, chosen.is_horizontal);
+            dilate_rows(fleet_rows, board_mask, blocked);
+        }
+    }
+
+    for (int i = 0; i < view->fleet_size; i++) {
+        if (placed[i]) continue;
+
+        int size = view->fleet[i];
+        BoardRow horizontal[BOARD_ROWS] = {0};
+        BoardRow vertical[BOARD_ROWS] = {0};
+        int total = 0;
+
+        for (int row = 0; row < n; row++) {
+            BoardRow open = view->free_cells[row] & (BoardRow)~blocked[row];
+            BoardRow starts = open;
+            for (int k = 1; k < size; k++) {
+                starts &= open >> k;
+            }
+            horizontal[row] = starts;
+            total += __builtin_popcount(starts);
+        }
+
+        if (size > 1) {
+            for (int row = 0; row + size <= n; row++) {
+                BoardRow starts = view->free_cells[row] & (BoardRow)~blocked[row];
+                for (int k = 1; k < size; k++) {
+                    starts &= view->free_cells[row + k] & (BoardRow)~blocked[row + k];
+                }
+                vertical[row] = starts;
+                total += __builtin_popcount(starts);
+            }
+        }
+
+        if (total == 0) return 0;
+
+        int pick = (int)(next_random(rng) % (uint64_t)total);
+        int is_horizontal = 1;
+        int start_row = -1;
+        BoardRow bits = 0;
+
+        for (int row = 0; row < n && start_row < 0; row++) {
+            int count = __builtin_popcount(horizontal[row]);
+            if (pick < count) {
+                start_row = row;
+                bits = horizontal[row];
+            } else {
+                pick -= count;
+            }
+        }
+        for (int row = 0; row < n && start_row < 0; row++) {
+            int count = __builtin_popcount(vertical[row]);
+            if (pick < count) {
+                start_row = row;
+                bits = vertical[row];
+                is_horizontal = 0;
+            } else {
+                pick -= count;
+            }
+        }
+
+        while (pick--) bits &= bits - 1;
+
+        add_ship(fleet_rows, size, __builtin_ctz(bits), start_row, is_horizontal);
+        dilate_rows(fleet_rows, board_mask, blocked);
+    }
+
+    for (int row = 0; row < n; row++) {
+        if (view->open_hits[row] & (BoardRow)~fleet_rows[row]) return 0;
+    }
+    return 1;
+}
+
+// Picks the most sampled cell among candidates; returns its count.
+static unsigned int best_sampled_cell(MonteCarloSearch *search, const BoardRow *candidates) {
+    const BotView *view = &search->view;
+    unsigned int best = 0;
+
+    for (int row = 0; row < view->size; row++) {
+        BoardRow bits = candidates[row];
+        while (bits) {
+            int col = __builtin_ctz(bits);
+            bits &= bits - 1;
+
+            unsigned int count = atomic_load_explicit(&search->counts[row][col], memory_order_relaxed);
+            if (count > best) {
+                best = count;
+                search->x = col;
+                search->y = row;
+            }
+        }
+    }
+
+    return best;
+}
+
+/*
+    While a ship is hit but afloat, only the cells next to its hits are
+    considered, so a thin sample cannot pull the shot into open water.
+*/
+static void finish_search(MonteCarloSearch *search) {
+    const BotView *view = &search->view;
+    int n = view->size;
+    BoardRow targets[BOARD_ROWS] = {0};
+
+    search->samples = atomic_load(&search->total_samples);
+
+    for (int row = 0; row < n; row++) {
+        BoardRow hits = view->open_hits[row];
+        BoardRow near = (BoardRow)(hits << 1) | (BoardRow)(hits >> 1);
+        if (row > 0) near |= view->open_hits[row - 1];
+        if (row + 1 < n) near |= view->open_hits[row + 1];
+        targets[row] = near & view->unshot[row];
+    }
+
+    if (best_sampled_cell(search, targets) == 0 &&
+        best_sampled_cell(search, view->unshot) == 0 &&
+        !bot_choose_density_shot(view, &search->x, &search->y)) {
+        search->x = -1;
+        search->y = -1;
+    }
+
+    search->done(search);
+}
+
+static void run_search_task(void *arg) {
+    MonteCarloSearch *search = arg;
+    const BotView *view = &search->view;
+
+    uint64_t rng = (uint64_t)monotonic_ns() ^ ((uint64_t)(uintptr_t)search << 7);
+    rng ^= (uint64_t)(atomic_fetch_add(&search->next_task, 1) + 1) * 0x9e3779b97f4a7c15ull;
+    if (!rng) rng = 1;
+
+    BoardRow board_mask[BOARD_ROWS] = {0};
+    for (int row = 0; row < view->size; row++) {
+        board_mask[row] = (BoardRow)((1u << view->size) - 1);
+    }
+
+    uint32_t counts[BOARD_ROWS][MAX_BOARD_SIZE];
+    memset(counts, 0, sizeof(counts));
+    uint64_t accepted = 0;
+
+    for (uint64_t attempt = 0; ; attempt++) {
+        if (attempt % DEADLINE_CHECK_INTERVAL == 0 && monotonic_ns() >= search->deadline_ns) {
+            break;
+        }
+
+        BoardRow fleet_rows[BOARD_ROWS];
+        if (!sample_fleet(view, board_mask, &rng, fleet_rows)) continue;
+
+        accepted++;
+        for (int row = 0; row < view->size; row++) {
+            BoardRow bits = fleet_rows[row];
+            while (bits) {
+                counts[row][__builtin_ctz(bits)]++;
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    for (int row = 0; row < view->size; row++) {
+        for (int col = 0; col < view->size; col++) {
+            if (counts[row][col]) {
+                atomic_fetch_add_explicit(&search->counts[row][col], counts[row][col], memory_order_relaxed);
+            }
+        }
+    }
+    atomic_fetch_add(&search->total_samples, accepted);
+
+    if (atomic_fetch_sub(&search->pending_tasks, 1) == 1) {
+        finish_search(search);
+    }
+}
+
+MonteCarloSearch* mc_search_create(const Board *board) {
+    MonteCarloSearch *search = calloc(1, sizeof(MonteCarloSearch));
+    if (!search) return NULL;
+
+    bot_observe(board, &search->view);
+    return search;
+}
+
+void mc_search_submit(WorkerPool *pool, MonteCarloSearch *search, int budget_us, mc_done_fn done) {
+    int tasks = worker_pool_size(pool);
+
+    search->done = done;
+    search->deadline_ns = monotonic_ns() + (int64_t)budget_us * 1000;
+    atomic_store(&search->next_task, 0);
+    atomic_store(&search->pending_tasks, tasks);
+
+    for (int i = 0; i < tasks; i++) {
+        if (!worker_pool_submit(pool, run_search_task, search)) {
+            // Tasks already queued finish on their own; account for the rest.
+            if (atomic_fetch_sub(&search->pending_tasks, tasks - i) == tasks - i) {
+                finish_search(search);
+            }
+            return;
+        }
+    }
+}
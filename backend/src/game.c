@@ -0,0 +1,232 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/random.h>
+
+#include "game.h"
+
+#define PLACEMENT_ATTEMPTS 10000
+#define DEFAULT_RANDOM_SEED 0x9e3779b97f4a7c15ull
+
+static _Thread_local uint64_t random_state;
+
+const GameVariant game_variants[VARIANT_COUNT] = {
+    [VARIANT_CLASSIC] = { "classic", 10, 10, {4, 3, 3, 2, 2, 2, 1, 1, 1, 1} },
+    [VARIANT_QUICK] = { "quick", 8, 6, {3, 2, 2, 1, 1, 1} },
+    [VARIANT_LARGE] = { "large", 16, 15, {5, 4, 4, 3, 3, 3, 2, 2, 2, 2, 1, 1, 1, 1, 1} },
+};
+
+void game_seed_random(uint64_t seed) {
+    random_state = seed ? seed : DEFAULT_RANDOM_SEED;
+}
+
+uint32_t game_random(void) {
+    if (!random_state) {
+        uint64_t seed = 0;
+        if (getrandom(&seed, sizeof(seed), 0) != sizeof(seed)) {
+            seed = (uint64_t)time(NULL) ^ (uint64_t)(uintptr_t)&seed;
+        }
+        game_seed_random(seed);
+    }
+
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return (uint32_t)(random_state >> 32);
+}
+
+int find_game_variant(const char *name) {
+    for (int i = 0; i < VARIANT_COUNT; i++) {
+        if (strcmp(game_variants[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void ship_rows_of(const Ship *ship, BoardRow *rows) {
+    memset(rows, 0, sizeof(BoardRow) * BOARD_ROWS);
+
+    if (ship->is_horizontal) {
+        rows[ship->y] = (BoardRow)(((1u << ship->size) - 1) << ship->x);
+    } else {
+        for (int i = 0; i < ship->size; i++) {
+            rows[ship->y + i] = (BoardRow)(1u << ship->x);
+        }
+    }
+}
+
+/*
+    Kernels whose bounds and board mask depend on the board size are
+    generated once per supported size, so every size gets constant loop
+    bounds and a constant mask. The public functions below switch on
+    board->size and call the matching copy.
+*/
+#define DEFINE_BOARD_KERNELS(N)                                                         \
+    static const BoardRow board_mask_##N[BOARD_ROWS] = {                                \
+        [0 ... N - 1] = (BoardRow)((1u << N) - 1)                                       \
+    };                                                                                  \
+                                                                                        \
+    static inline int fits_clear_##N(const BoardRow *blocked, int x, int y,            \
+                                     int size, int horizontal) {                        \
+        if (horizontal) {                                                               \
+            if (x + size > N) return 0;                                                 \
+            return (blocked[y] & (BoardRow)(((1u << size) - 1) << x)) == 0;             \
+        }                                                                               \
+                                                                                        \
+        if (y + size > N) return 0;                                                     \
+        for (int i = 0; i < size; i++) {                                                \
+            if ((blocked[y + i] >> x) & 1) return 0;                                    \
+        }                                                                               \
+        return 1;                                                                       \
+    }                                                                                   \
+                                                                                        \
+    static int can_place_ship_##N(Board *board, int x, int y, int size, int horizontal) { \
+        _Alignas(32) BoardRow blocked[BOARD_ROWS];                                      \
+        dilate_rows(board->ship_rows, board_mask_##N, blocked);                         \
+                                                                                        \
+        return fits_clear_##N(blocked, x, y, size, horizontal);                         \
+    }                                                                                   \
+                                                                                        \
+    static int try_setup_random_board_##N(Board *board, const GameVariant *variant) {  \
+        _Alignas(32) BoardRow blocked[BOARD_ROWS] = {0};                                \
+                                                                                        \
+        for (int i = 0; i < variant->ship_count; i++) {                                 \
+            int size = variant->fleet[i];                                               \
+            int placed = 0;                                                             \
+                                                                                        \
+            for (int attempt = 0; !placed; attempt++) {                                 \
+                if (attempt == PLACEMENT_ATTEMPTS) return 0;                            \
+                                                                                        \
+                uint32_t r = game_random();                                             \
+                int x = (int)((r & 0xffff) % N);                                        \
+                int y = (int)((r >> 16) % N);                                           \
+                int horizontal = (int)(game_random() & 1);                              \
+                                                                                        \
+                if (fits_clear_##N(blocked, x, y, size, horizontal)) {                  \
+                    place_ship(board, x, y, size, horizontal);                          \
+                    dilate_rows(board->ship_rows, board_mask_##N, blocked);             \
+                    placed = 1;                                                         \
+                }                                                                       \
+            }                                                                           \
+        }                                                                               \
+        return 1;                                                                       \
+    }                                                                                   \
+                                                                                        \
+    static inline int check_hit_##N(Board *board, int x, int y) {                      \
+        if (x < 0 || x >= N || y < 0 || y >= N) {                                       \
+            return 0;                                                                   \
+        }                                                                               \
+                                                                                        \
+        BoardRow bit = (BoardRow)(1u << x);                                             \
+                                                                                        \
+        if (board->shot_rows[y] & bit) {                                                \
+            return 0;                                                                   \
+        }                                                                               \
+        board->shot_rows[y] |= bit;                                                     \
+                                                                                        \
+        if (board->ship_rows[y] & bit) {                                                \
+            for (int i = 0; i < board->ship_count; i++) {                               \
+                Ship *ship = &board->ships[i];                                          \
+                if (ship_contains(ship, x, y)) {                                        \
+                    if (ship_hits(board, ship) == ship->size) {                         \
+                        board->ships_afloat--;                                          \
+                    }                                                                   \
+                    return 1;                                                           \
+                }                                                                       \
+            }                                                                           \
+        }                                                                               \
+                                                                                        \
+        return 0;                                                                       \
+    }                                                                                   \
+                                                                                        \
+    static void sunk_the_ship_##N(Board *board, int sunked_ship_ind) {                 \
+        _Alignas(32) BoardRow ship[BOARD_ROWS];                                         \
+        _Alignas(32) BoardRow halo[BOARD_ROWS];                                         \
+                                                                                        \
+        ship_rows_of(&board->ships[sunked_ship_ind], ship);                             \
+        dilate_rows(ship, board_mask_##N, halo);                                        \
+                                                                                        \
+        for (int y = 0; y < N; y++) {                                                   \
+            board->shot_rows[y] |= halo[y];                                             \
+        }                                                                               \
+    }
+
+SUPPORTED_BOARD_SIZES(DEFINE_BOARD_KERNELS)
+
+#define CAN_PLACE_SHIP_CASE(N) case N: return can_place_ship_##N(board, x, y, size, horizontal);
+#define SETUP_RANDOM_BOARD_CASE(N) case N: placed = try_setup_random_board_##N(board, variant); break;
+#define CHECK_HIT_CASE(N) case N: return check_hit_##N(board, x, y);
+#define SUNK_THE_SHIP_CASE(N) case N: sunk_the_ship_##N(board, sunked_ship_ind); break;
+
+void init_board(Board *board, int size) {
+    memset(board, 0, sizeof(Board));
+    board->size = size;
+}
+
+int can_place_ship(Board *board, int x, int y, int size, int horizontal) {
+    switch (board->size) {
+        SUPPORTED_BOARD_SIZES(CAN_PLACE_SHIP_CASE)
+    }
+    return 0;
+}
+
+void place_ship(Board *board, int x, int y, int size, int horizontal) {
+    Ship *ship = &board->ships[board->ship_count++];
+    ship->x = x;
+    ship->y = y;
+    ship->size = size;
+    ship->is_horizontal = horizontal;
+    board->ships_afloat++;
+
+    if (horizontal) {
+        board->ship_rows[y] |= (BoardRow)(((1u << size) - 1) << x);
+    } else {
+        for (int i = 0; i < size; i++) {
+            board->ship_rows[y + i] |= (BoardRow)(1u << x);
+        }
+    }
+}
+
+void setup_random_board(Board *board, const GameVariant *variant) {
+    int placed = 0;
+
+    // A crowded fleet can paint itself into a corner; start over when it does.
+    while (!placed) {
+        init_board(board, variant->board_size);
+
+        switch (board->size) {
+            SUPPORTED_BOARD_SIZES(SETUP_RANDOM_BOARD_CASE)
+            default: return;
+        }
+    }
+}
+
+int check_hit(Board *board, int x, int y) {
+    switch (board->size) {
+        SUPPORTED_BOARD_SIZES(CHECK_HIT_CASE)
+    }
+    return 0;
+}
+
+int is_ship_sunk(Board *board, int x, int y) {
+    for (int i = 0; i < board->ship_count; i++) {
+        if (ship_contains(&board->ships[i], x, y)) {
+            return (ship_hits(board, &board->ships[i]) == board->ships[i].size) ? i : -1;
+        }
+    }
+
+    return -1;
+}
+
+void sunk_the_ship(Board *board, int sunked_ship_ind) {
+    if (sunked_ship_ind > -1) {
+        switch (board->size) {
+            SUPPORTED_BOARD_SIZES(SUNK_THE_SHIP_CASE)
+        }
+    }
+}
+
+int is_game_over(Board *board) {
+    return board->ships_afloat == 0;
+}
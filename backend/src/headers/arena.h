@@ -0,0 +1,55 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/*
+    Bump allocator for everything one request or one WebSocket message
+    allocates. Nothing is freed individually; arena_reset gives it all back
+    at once and rewinds to the caller's initial buffer.
+
+    While an arena is entered on a thread, jansson allocates from it (see
+    arena_install_json_hooks), so a parsed or built JSON tree costs no
+    malloc/free per node. Trees must not outlive the reset.
+*/
+
+#define ARENA_ALIGN 16
+#define ARENA_BLOCK_SIZE 16384
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    _Alignas(ARENA_ALIGN) unsigned char data[];
+} ArenaBlock;
+
+typedef struct {
+    unsigned char *ptr;
+    unsigned char *end;
+    unsigned char *last;
+    unsigned char *initial;
+    size_t initial_size;
+    ArenaBlock *blocks;
+} Arena;
+
+extern _Thread_local Arena *arena_current;
+
+void arena_init(Arena *arena, void *initial, size_t initial_size);
+void* arena_alloc(Arena *arena, size_t size);
+/* Resizes ptr, in place when it is the latest allocation and there is room. */
+void* arena_grow(Arena *arena, void *ptr, size_t old_size, size_t new_size);
+/* Frees the overflow blocks and rewinds to the initial buffer. */
+void arena_reset(Arena *arena);
+
+/* Routes jansson's allocations to arena_current, or to malloc outside one. */
+void arena_install_json_hooks(void);
+
+static inline Arena* arena_enter(Arena *arena) {
+    Arena *previous = arena_current;
+    arena_current = arena;
+    return previous;
+}
+
+static inline void arena_leave(Arena *previous) {
+    arena_current = previous;
+}
+
+#endif // ARENA_H
@@ -0,0 +1,30 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <stdint.h>
+
+/*
+    A bitboard is BOARD_ROWS words, one bit per cell. Rows are padded to 16
+    so a whole board is one 256-bit AVX2 register or two SSE2 registers.
+*/
+#define BOARD_ROWS 16
+
+typedef uint16_t BoardRow;
+
+typedef void (*dilate_rows_fn)(const BoardRow *rows, const BoardRow *mask, BoardRow *out);
+
+/*
+    out = (rows grown by one cell in all eight directions) & mask.
+    Points at the fastest implementation the CPU supports.
+*/
+extern dilate_rows_fn dilate_rows;
+
+void dilate_rows_scalar(const BoardRow *rows, const BoardRow *mask, BoardRow *out);
+#if defined(__x86_64__) || defined(__i386__)
+void dilate_rows_sse2(const BoardRow *rows, const BoardRow *mask, BoardRow *out);
+void dilate_rows_avx2(const BoardRow *rows, const BoardRow *mask, BoardRow *out);
+#endif
+
+const char* dilate_rows_impl_name(void);
+
+#endif // BITBOARD_H
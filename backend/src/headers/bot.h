@@ -0,0 +1,45 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include "game.h"
+#include "session.h"
+
+#define BOT_PLAYER_NAME "Bot"
+
+typedef enum {
+    BOT_NONE,
+    BOT_DENSITY,
+    BOT_MONTE_CARLO
+} BotKind;
+
+/* What a shooter can see of the target board, in bitboard form. */
+typedef struct {
+    BoardRow free_cells[BOARD_ROWS];
+    BoardRow open_hits[BOARD_ROWS];
+    BoardRow unshot[BOARD_ROWS];
+    uint8_t fleet[MAX_SHIPS];
+    uint8_t fleet_size;
+    uint8_t size;
+} BotView;
+
+/*
+    free_cells: cells that may still hold an unsunk ship.
+    open_hits: hits on ships that are still afloat.
+    fleet: sizes of the ships still afloat, largest first.
+*/
+void bot_observe(const Board *board, BotView *view);
+int bot_choose_density_shot(const BotView *view, int *x, int *y);
+
+/*
+    Picks the unshot cell covered by the most fleet placements that are
+    still consistent with what the shooter can see on the board.
+    Returns 0 when no unshot cell is left.
+*/
+int bot_choose_shot(const Board *board, int *x, int *y);
+
+int attach_bot(SessionStore *store, GameSession *session, BotKind kind);
+
+/* Plays density-bot shots until it misses; returns 1 if the game is over. */
+int play_bot_turn(GameSession *session);
+
+#endif // BOT_H
@@ -0,0 +1,56 @@
+#ifndef BOT_MC_H
+#define BOT_MC_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "bot.h"
+#include "session.h"
+#include "worker_pool.h"
+
+#define MC_BOT_BUDGET_US 20000
+
+typedef struct MonteCarloSearch MonteCarloSearch;
+
+typedef void (*mc_done_fn)(MonteCarloSearch *search);
+
+/*
+    One "hard" bot move. The caller fills the owner fields, submits it, and
+    gets it back through done() on a worker thread, with x/y set to the
+    cell that held a ship in the most sampled fleets, next to an open hit
+    if there is one. done() owns the search from then on and releases it
+    with free().
+*/
+struct MonteCarloSearch {
+    // owner fields
+    MonteCarloSearch *next;
+    SessionId session_id;
+    uint32_t move_seq;
+    void *user;
+
+    // results
+    int x;
+    int y;
+    uint64_t samples;
+
+    // private
+    BotView view;
+    mc_done_fn done;
+    int64_t deadline_ns;
+    atomic_int next_task;
+    atomic_int pending_tasks;
+    atomic_uint_fast64_t total_samples;
+    atomic_uint counts[BOARD_ROWS][MAX_BOARD_SIZE];
+};
+
+MonteCarloSearch* mc_search_create(const Board *board);
+
+/*
+    Starts one sampling task per pool thread. Every task stops at
+    now + budget_us, so the move is ready after the budget even when the
+    pool is busy. done() runs exactly once, on the caller's thread if no
+    task could be queued.
+*/
+void mc_search_submit(WorkerPool *pool, MonteCarloSearch *search, int budget_us, mc_done_fn done);
+
+#endif // BOT_MC_H
@@ -0,0 +1,107 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <stdint.h>
+
+#include "bitboard.h"
+
+#define MAX_BOARD_SIZE 16
+#define MAX_SHIPS 16
+
+/* Board sizes with compiled kernels; see DEFINE_BOARD_KERNELS in game.c. */
+#define SUPPORTED_BOARD_SIZES(X) X(8) X(10) X(16)
+
+/* Cell values as they appear on the wire. */
+typedef enum {
+    EMPTY,
+    SHIP,
+    HIT,
+    MISS
+} CellState;
+
+typedef enum {
+    VARIANT_CLASSIC,
+    VARIANT_QUICK,
+    VARIANT_LARGE,
+    VARIANT_COUNT
+} GameVariantId;
+
+typedef struct {
+    const char *name;
+    uint8_t board_size;
+    uint8_t ship_count;
+    uint8_t fleet[MAX_SHIPS];
+} GameVariant;
+
+/* Hits are not stored; they are counted from shot_rows under the ship. */
+typedef struct {
+    uint8_t x : 4;
+    uint8_t y : 4;
+    uint8_t size : 5;
+    uint8_t is_horizontal : 1;
+} Ship;
+
+/*
+    Cells are kept as two bitboards, one bit per cell and one row per word:
+    ship_rows marks ship cells, shot_rows marks cells that were fired at.
+    EMPTY, SHIP, HIT and MISS are the four combinations of the two bits.
+    Rows and columns past size stay zero.
+*/
+typedef struct {
+    BoardRow ship_rows[BOARD_ROWS];
+    BoardRow shot_rows[BOARD_ROWS];
+    Ship ships[MAX_SHIPS];
+    uint8_t ship_count;
+    uint8_t ships_afloat;
+    uint8_t size;
+} Board;
+
+extern const GameVariant game_variants[VARIANT_COUNT];
+
+static inline CellState board_cell(const Board *board, int x, int y) {
+    int ship = (board->ship_rows[y] >> x) & 1;
+    int shot = (board->shot_rows[y] >> x) & 1;
+
+    if (shot) return ship ? HIT : MISS;
+    return ship ? SHIP : EMPTY;
+}
+
+static inline int ship_hits(const Board *board, const Ship *ship) {
+    if (ship->is_horizontal) {
+        BoardRow mask = (BoardRow)(((1u << ship->size) - 1) << ship->x);
+        return __builtin_popcount(board->shot_rows[ship->y] & mask);
+    }
+
+    int hits = 0;
+    for (int i = 0; i < ship->size; i++) {
+        hits += (board->shot_rows[ship->y + i] >> ship->x) & 1;
+    }
+    return hits;
+}
+
+static inline int ship_contains(const Ship *ship, int x, int y) {
+    if (ship->is_horizontal) {
+        return y == ship->y && x >= ship->x && x < ship->x + ship->size;
+    }
+    return x == ship->x && y >= ship->y && y < ship->y + ship->size;
+}
+
+int find_game_variant(const char *name);
+void init_board(Board *board, int size);
+int can_place_ship(Board *board, int x, int y, int size, int horizontal);
+void place_ship(Board *board, int x, int y, int size, int horizontal);
+void setup_random_board(Board *board, const GameVariant *variant);
+int check_hit(Board *board, int x, int y);
+int is_ship_sunk(Board *board, int x, int y);
+void sunk_the_ship(Board *board, int sunked_ship_ind);
+int is_game_over(Board *board);
+
+/*
+    Per-thread generator behind board setup and the bots. A thread seeds
+    itself from getrandom() on first use; game_seed_random() makes its
+    sequence reproducible instead.
+*/
+uint32_t game_random(void);
+void game_seed_random(uint64_t seed);
+
+#endif // GAME_H
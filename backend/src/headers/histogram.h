@@ -0,0 +1,52 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+
+/*
+    Log-linear histogram: every power of two is split into
+    HISTOGRAM_SUB_BUCKETS equal buckets, so any recorded value is reported
+    within about 3% for the whole uint64_t range.
+*/
+#define HISTOGRAM_SUB_BITS 5
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS ((64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS)
+
+typedef struct {
+    uint64_t count;
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+    uint64_t buckets[HISTOGRAM_BUCKETS];
+} Histogram;
+
+static inline int histogram_bucket(uint64_t value) {
+    if (value < HISTOGRAM_SUB_BUCKETS) {
+        return (int)value;
+    }
+
+    int exponent = 63 - __builtin_clzll(value);
+    int shift = exponent - HISTOGRAM_SUB_BITS;
+    int sub = (int)((value >> shift) & (HISTOGRAM_SUB_BUCKETS - 1));
+
+    return (shift + 1) * HISTOGRAM_SUB_BUCKETS + sub;
+}
+
+/* Smallest value that lands in the bucket. */
+static inline uint64_t histogram_bucket_lower_bound(int bucket) {
+    int row = bucket / HISTOGRAM_SUB_BUCKETS;
+    uint64_t sub = (uint64_t)(bucket % HISTOGRAM_SUB_BUCKETS);
+
+    if (row == 0) return sub;
+    return (HISTOGRAM_SUB_BUCKETS + sub) << (row - 1);
+}
+
+void histogram_init(Histogram *histogram);
+void histogram_record(Histogram *histogram, uint64_t value);
+void histogram_merge(Histogram *dst, const Histogram *src);
+
+/* Value below which the given fraction (0..1) of samples fall. */
+uint64_t histogram_percentile(const Histogram *histogram, double fraction);
+double histogram_mean(const Histogram *histogram);
+
+#endif // HISTOGRAM_H
@@ -0,0 +1,90 @@
+#ifndef HTTP_SERVER_H
+#define HTTP_SERVER_H
+
+#include <stddef.h>
+#include <microhttpd.h>
+
+#include "arena.h"
+
+#define MHD_MAX_JSON_SIZE 4096
+// Rows shown by /debug/locks and the SIGUSR1 dump.
+#define LOCK_PROFILE_ROWS 20
+
+// Inline start of a request's arena; covers the body and JSON of typical requests.
+#define CONNECTION_ARENA_SIZE 8192
+// Contexts kept for reuse; more concurrent requests fall back to malloc.
+#define CONNECTION_POOL_SIZE 256
+
+// Sessions copied and slots scanned per lock hold while streaming a listing, and MHD's block size for it.
+#define SESSION_STREAM_BATCH 32
+#define SESSION_STREAM_SCAN 1024
+#define SESSION_STREAM_BLOCK_SIZE 8192
+
+/*
+    Per-request state, taken from a lock-free pool. The body and every JSON
+    tree of the request live in arena, so finishing a request is a single
+    reset and a push back onto the pool.
+*/
+struct connection_info {
+    Arena arena;
+    char *upload_data;
+    size_t upload_data_size;
+    size_t upload_data_cap;
+    // Body went over MHD_MAX_JSON_SIZE; the rest of it is discarded.
+    int too_large;
+    // Slot in the pool, or -1 if malloc'd.
+    int pool_slot;
+    unsigned char arena_initial[CONNECTION_ARENA_SIZE];
+};
+
+/* expected_size is the Content-Length, or 0 if unknown; the body buffer is sized for it. */
+struct connection_info* connection_info_create(size_t expected_size);
+/* Appends one upload chunk to the request body. Returns 0 if out of memory. */
+int connection_info_append(struct connection_info *con_info, const char *data, size_t size);
+void connection_info_free(struct connection_info *con_info);
+
+typedef enum {
+    HTTP_ERROR_NOT_FOUND,
+    HTTP_ERROR_METHOD_NOT_ALLOWED,
+    HTTP_ERROR_UNAUTHORIZED,
+    HTTP_ERROR_FORBIDDEN,
+    HTTP_ERROR_INVALID_JSON,
+    HTTP_ERROR_MISSING_FIELDS,
+    HTTP_ERROR_MISSING_PLAYER_NAME,
+    HTTP_ERROR_UNKNOWN_VARIANT,
+    HTTP_ERROR_UNKNOWN_OPPONENT,
+    HTTP_ERROR_UNKNOWN_DIFFICULTY,
+    HTTP_ERROR_CANNOT_JOIN,
+    HTTP_ERROR_PAYLOAD_TOO_LARGE,
+    HTTP_ERROR_MAX_SESSIONS,
+    HTTP_ERROR_QUICKMATCH_FULL,
+    HTTP_ERROR_INTERNAL,
+    HTTP_ERROR_COUNT
+} HttpError;
+
+/* Builds the route table and the shared responses; call before starting MHD. Returns 0 on failure. */
+int http_server_init(void);
+void http_server_destroy(void);
+
+/* MHD_queue_response that also remembers the status for the metrics. */
+int queue_response(struct MHD_Connection *connection, int status_code, struct MHD_Response *response);
+/* Queues one of the prebuilt error responses; allocates nothing. */
+int send_error(struct MHD_Connection *connection, HttpError error);
+
+/*
+    PARAMS:
+    cls - user data
+    connection - current HTTP connection
+    url - url
+    method - request method
+    version - HTTP version
+    upload_data - request body
+    upload_data_size - request body size
+    con_cls - data about connect
+*/
+enum MHD_Result http_handler(void *cls, struct MHD_Connection *connection,
+    const char *url, const char *method,
+    const char *version, const char *upload_data,
+    size_t *upload_data_size, void **con_cls);
+
+#endif // HTTP_SERVER_H
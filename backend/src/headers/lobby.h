@@ -0,0 +1,42 @@
+#ifndef LOBBY_H
+#define LOBBY_H
+
+#include "session.h"
+
+/*
+    Live lobby: sockets that sent "subscribe_lobby" get a lobby_snapshot of
+    the waiting sessions, then lobby_added / lobby_removed as sessions
+    start or stop waiting for a second player.
+
+    Events are formatted on the thread that changed the session and pushed
+    onto a lock-free inbox; the lws thread sends them out on
+    LWS_CALLBACK_EVENT_WAIT_CANCELLED. Publishers hold server_state.mutex,
+    so events leave in the order the changes were made.
+
+    Events are numbered under that mutex too. A snapshot records the last
+    number it reflects, and its subscriber skips events up to it that were
+    still in the inbox when it subscribed.
+*/
+
+typedef struct LobbyEvent {
+    struct LobbyEvent *next;
+    uint64_t seq;
+    char text[];
+} LobbyEvent;
+
+typedef struct {
+    struct lws *wsi;
+    // Last event already reflected in the snapshot wsi was sent.
+    uint64_t seen_seq;
+} LobbySubscriber;
+
+/* Called with server_state.mutex held, from any thread. */
+void lobby_session_added(const GameSession *session, const SessionInfo *info);
+void lobby_session_removed(SessionId id);
+
+/* lws thread only. */
+void lobby_subscribe(struct lws *wsi);
+void lobby_unsubscribe(struct lws *wsi);
+void lobby_flush(void);
+
+#endif // LOBBY_H
@@ -0,0 +1,93 @@
+#ifndef LOCK_PROFILE_H
+#define LOCK_PROFILE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/*
+    Mutex that records, per call site, how long callers waited for it and
+    how long they held it. Built with LOCK_PROFILING (make LOCK_PROFILING=1);
+    otherwise ProfMutex is a plain pthread_mutex_t and the sites vanish.
+
+    Lock through PROF_MUTEX_LOCK so every call site gets its own LockSite.
+*/
+
+static inline uint64_t lock_profile_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+#ifdef LOCK_PROFILING
+
+typedef struct LockSite {
+    struct LockSite *next;
+    const char *file;
+    const char *function;
+    int line;
+    atomic_int registered;
+    _Atomic uint64_t acquisitions;
+    _Atomic uint64_t contended;
+    _Atomic uint64_t wait_ns;
+    _Atomic uint64_t max_wait_ns;
+    _Atomic uint64_t hold_ns;
+    _Atomic uint64_t max_hold_ns;
+} LockSite;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    // Written only by the holder.
+    LockSite *holder;
+    uint64_t acquired_ns;
+} ProfMutex;
+
+#define PROF_MUTEX_LOCK(m, wait_ns_out) do { \
+        static LockSite lock_site_ = { .file = __FILE__, .function = __func__, .line = __LINE__ }; \
+        *(wait_ns_out) = prof_mutex_lock((m), &lock_site_); \
+    } while (0)
+
+int prof_mutex_init(ProfMutex *m);
+void prof_mutex_destroy(ProfMutex *m);
+uint64_t prof_mutex_lock(ProfMutex *m, LockSite *site);
+void prof_mutex_unlock(ProfMutex *m);
+
+#else
+
+typedef pthread_mutex_t ProfMutex;
+
+#define PROF_MUTEX_LOCK(m, wait_ns_out) (*(wait_ns_out) = prof_mutex_lock((m)))
+
+static inline int prof_mutex_init(ProfMutex *m) {
+    return pthread_mutex_init(m, NULL) == 0;
+}
+
+static inline void prof_mutex_destroy(ProfMutex *m) {
+    pthread_mutex_destroy(m);
+}
+
+/* Returns how long the caller waited; 0 when the lock was free. */
+static inline uint64_t prof_mutex_lock(ProfMutex *m) {
+    if (pthread_mutex_trylock(m) == 0) return 0;
+
+    uint64_t start = lock_profile_now_ns();
+    pthread_mutex_lock(m);
+    uint64_t wait_ns = lock_profile_now_ns() - start;
+    return wait_ns ? wait_ns : 1;
+}
+
+static inline void prof_mutex_unlock(ProfMutex *m) {
+    pthread_mutex_unlock(m);
+}
+
+#endif // LOCK_PROFILING
+
+/*
+    Writes a table of call sites, worst total wait first, at most limit rows.
+    Says so when profiling is compiled out.
+*/
+void lock_profile_write(FILE *out, int limit);
+
+#endif // LOCK_PROFILE_H
@@ -0,0 +1,85 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+/*
+    Asynchronous logger. A log call formats its record on the calling thread
+    into that thread's ring and returns; a background thread started by
+    log_start writes the rings to stdout. When a ring is full the record is
+    dropped and counted, so logging never blocks a network thread.
+
+    Records are logfmt: a message name followed by key=value fields.
+
+        LOG(LOG_INFO, "ws_connected", "clients=%d", count);
+*/
+
+#define LOG_RING_RECORDS 1024
+#define LOG_RECORD_TEXT 232
+
+typedef enum {
+    LOG_DEBUG,
+    LOG_INFO,
+    LOG_WARN,
+    LOG_ERROR
+} LogLevel;
+
+typedef struct {
+    uint64_t time_ns;
+    uint8_t level;
+    uint16_t len;
+    char text[LOG_RECORD_TEXT];
+} LogRecord;
+
+typedef struct LogRing {
+    struct LogRing *next;
+    atomic_int in_use;
+    int thread_slot;
+    _Atomic uint64_t head;
+    _Atomic uint64_t tail;
+    LogRecord records[LOG_RING_RECORDS];
+} LogRing;
+
+// Per call site budget of records per second, see LOG_RATE_LIMITED.
+typedef struct {
+    int per_second;
+    _Atomic int64_t window;
+    atomic_int count;
+    _Atomic uint64_t suppressed;
+} LogRateLimit;
+
+extern atomic_int log_min_level;
+
+static inline int log_enabled(LogLevel level) {
+    return (int)level >= atomic_load_explicit(&log_min_level, memory_order_relaxed);
+}
+
+/* Returns -1 if the record is over budget, else how many were suppressed before it. */
+int64_t log_rate_check(LogRateLimit *limit);
+
+__attribute__((format(printf, 4, 5)))
+void log_write(LogLevel level, uint64_t suppressed, const char *message, const char *fields, ...);
+
+#define LOG(level, message, ...) do { \
+        if (log_enabled(level)) log_write((level), 0, (message), __VA_ARGS__); \
+    } while (0)
+
+// For messages a client can trigger at will: at most budget records per second.
+#define LOG_RATE_LIMITED(level, budget, message, ...) do { \
+        static LogRateLimit log_limit_ = { .per_second = (budget) }; \
+        if (log_enabled(level)) { \
+            int64_t log_suppressed_ = log_rate_check(&log_limit_); \
+            if (log_suppressed_ >= 0) log_write((level), (uint64_t)log_suppressed_, (message), __VA_ARGS__); \
+        } \
+    } while (0)
+
+/* Parses debug|info|warn|error. Returns 0 if unknown. */
+int log_parse_level(const char *name, LogLevel *level);
+void log_set_level(LogLevel level);
+
+int log_start(void);
+/* Stops the writer thread after it has written everything queued. */
+void log_stop(void);
+
+#endif // LOG_H
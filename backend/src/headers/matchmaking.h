@@ -0,0 +1,54 @@
+#ifndef MATCHMAKING_H
+#define MATCHMAKING_H
+
+#include <time.h>
+
+#include "session.h"
+
+/*
+    Quick-match queue. A player waits on a WebSocket, either by sending
+    "quickmatch" with a name and variant or by claiming a ticket from
+    POST /quickmatch. Two waiting players of the same variant get a new
+    session with both boards set up, and both sockets are bound to it and
+    told the session id.
+
+    Tickets are pushed from any thread onto a lock-free inbox. Everything
+    else belongs to the lws service thread, which drains the inbox when a
+    socket claims a ticket and once a second to expire unclaimed ones.
+    At most QUICKMATCH_MAX_TICKETS are outstanding at a time, so a client
+    that never claims its tickets cannot grow the list without bound.
+*/
+
+// Seconds a ticket from POST /quickmatch stays claimable.
+#define QUICKMATCH_TICKET_TTL 60
+// Tickets handed out and neither claimed nor expired yet.
+#define QUICKMATCH_MAX_TICKETS 4096
+
+typedef enum {
+    QUICKMATCH_REGISTERED,
+    QUICKMATCH_FULL,
+    QUICKMATCH_ERROR
+} QuickmatchResult;
+
+typedef struct MatchRequest {
+    struct MatchRequest *next;
+    // NULL until a socket claims the ticket.
+    struct lws *wsi;
+    PlayerToken ticket;
+    time_t expires_at;
+    int variant;
+    char player_name[PLAYER_NAME_LEN];
+} MatchRequest;
+
+/* Any thread. QUICKMATCH_ERROR if out of memory or randomness. */
+QuickmatchResult quickmatch_register(const char *player_name, int variant, PlayerToken *ticket);
+
+/* lws thread only. Each returns 0 if the request was refused. */
+int quickmatch_join(struct lws *wsi, const char *player_name, int variant);
+int quickmatch_claim(struct lws *wsi, PlayerToken ticket);
+/* Drops wsi from the queue, e.g. when it closes. */
+void quickmatch_cancel(struct lws *wsi);
+/* Frees expired tickets; does the work at most once a second. */
+void quickmatch_expire_tickets(void);
+
+#endif // MATCHMAKING_H
@@ -0,0 +1,125 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "histogram.h"
+
+/*
+    Every thread records into its own shard, so recording is a thread-local
+    load and store with no locked instruction. /metrics sums the shards.
+    A shard outlives its thread and is handed to the next new thread, so
+    totals survive MHD's short-lived connection threads.
+*/
+
+typedef enum {
+    METRIC_MOVES,
+    METRIC_BOT_MOVES,
+    METRIC_SERIALIZED_BYTES,
+    METRIC_WS_CONNECTIONS,
+    METRIC_WS_SEND_QUEUE_DEPTH,
+    METRIC_SPECTATORS,
+    METRIC_SPECTATOR_FRAMES_DROPPED,
+    METRIC_LOCK_ACQUISITIONS,
+    METRIC_LOCK_CONTENDED,
+    METRIC_COUNTER_COUNT
+} MetricCounter;
+
+typedef enum {
+    METRIC_MOVE_DURATION,
+    METRIC_HTTP_REQUEST_DURATION,
+    METRIC_LOCK_WAIT,
+    METRIC_HISTOGRAM_COUNT
+} MetricHistogram;
+
+typedef enum {
+    HTTP_ROUTE_CREATE,
+    HTTP_ROUTE_JOIN,
+    HTTP_ROUTE_QUICKMATCH,
+    HTTP_ROUTE_SESSIONS,
+    HTTP_ROUTE_SESSION,
+    HTTP_ROUTE_METRICS,
+    HTTP_ROUTE_DEBUG_LOCKS,
+    HTTP_ROUTE_DEBUG_TRACE,
+    HTTP_ROUTE_DEBUG_SESSIONS,
+    HTTP_ROUTE_OTHER,
+    HTTP_ROUTE_COUNT
+} HttpRoute;
+
+typedef enum {
+    HTTP_STATUS_200,
+    HTTP_STATUS_204,
+    HTTP_STATUS_304,
+    HTTP_STATUS_400,
+    HTTP_STATUS_401,
+    HTTP_STATUS_403,
+    HTTP_STATUS_404,
+    HTTP_STATUS_405,
+    HTTP_STATUS_413,
+    HTTP_STATUS_500,
+    HTTP_STATUS_503,
+    HTTP_STATUS_OTHER,
+    HTTP_STATUS_COUNT
+} HttpStatusClass;
+
+typedef struct {
+    _Atomic uint64_t count;
+    _Atomic uint64_t sum;
+    _Atomic uint64_t buckets[HISTOGRAM_BUCKETS];
+} MetricsHistogram;
+
+typedef struct MetricsShard {
+    struct MetricsShard *next;
+    atomic_int in_use;
+    _Atomic int64_t counters[METRIC_COUNTER_COUNT];
+    _Atomic uint64_t http_requests[HTTP_ROUTE_COUNT][HTTP_STATUS_COUNT];
+    MetricsHistogram histograms[METRIC_HISTOGRAM_COUNT];
+} MetricsShard;
+
+extern _Thread_local MetricsShard *metrics_thread_shard;
+
+MetricsShard* metrics_attach_thread(void);
+
+static inline MetricsShard* metrics_shard(void) {
+    MetricsShard *shard = metrics_thread_shard;
+    return shard ? shard : metrics_attach_thread();
+}
+
+// Single writer per shard: a relaxed load and store is enough.
+static inline void metrics_bump(_Atomic uint64_t *cell, uint64_t delta) {
+    atomic_store_explicit(cell, atomic_load_explicit(cell, memory_order_relaxed) + delta, memory_order_relaxed);
+}
+
+/* Counters only grow; gauges are counters that also take negative deltas. */
+static inline void metrics_add(MetricCounter counter, int64_t delta) {
+    _Atomic int64_t *cell = &metrics_shard()->counters[counter];
+    atomic_store_explicit(cell, atomic_load_explicit(cell, memory_order_relaxed) + delta, memory_order_relaxed);
+}
+
+static inline void metrics_observe(MetricHistogram histogram, uint64_t value_ns) {
+    MetricsHistogram *h = &metrics_shard()->histograms[histogram];
+    metrics_bump(&h->buckets[histogram_bucket(value_ns)], 1);
+    metrics_bump(&h->count, 1);
+    metrics_bump(&h->sum, value_ns);
+}
+
+void metrics_count_http_request(HttpRoute route, int status_code);
+
+static inline uint64_t metrics_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+typedef struct {
+    int64_t in_progress;
+    int64_t waiting;
+    int64_t finished;
+} SessionGauges;
+
+/* Prometheus text exposition; the caller frees the string. */
+char* metrics_render(const SessionGauges *sessions, size_t *len);
+
+#endif // METRICS_H
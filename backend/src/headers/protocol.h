@@ -0,0 +1,22 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <jansson.h>
+
+#include "game.h"
+#include "session.h"
+
+json_t* serialize_board(const Board *board);
+
+/* Entry of the lobby listing: id, player1, created_at, variant, board_size. */
+json_t* serialize_lobby_session(const GameSession *session, const SessionInfo *info);
+
+/* Compact JSON text from malloc, counted in the serialized-bytes metric. */
+char* dump_json(const json_t *root);
+
+/* game_state message as seen by player_num; the caller frees the string. */
+char* build_game_state_message(const GameSession *session, int player_num);
+/* Public view of a session: no ship is shown until it is sunk. The caller frees the string. */
+char* build_public_state_message(const GameSession *session, const SessionInfo *info);
+
+#endif // PROTOCOL_H
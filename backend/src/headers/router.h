@@ -0,0 +1,65 @@
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#include <stddef.h>
+
+/*
+    Path router. Patterns are added once at startup and compiled into a
+    trie of path segments; a "{name}" segment matches any one segment.
+    Matching walks the request path in place: parameters are slices of
+    the path, so a lookup allocates nothing.
+*/
+
+#define ROUTER_MAX_NODES 64
+#define ROUTER_MAX_PARAMS 4
+#define ROUTER_MAX_DEPTH 8
+
+typedef enum {
+    ROUTER_GET,
+    ROUTER_POST,
+    ROUTER_PUT,
+    ROUTER_DELETE,
+    ROUTER_HEAD,
+    ROUTER_METHOD_COUNT
+} RouterMethod;
+
+typedef enum {
+    ROUTE_FOUND,
+    ROUTE_NOT_FOUND,
+    ROUTE_METHOD_NOT_ALLOWED
+} RouteResult;
+
+typedef struct {
+    const char *start;
+    size_t len;
+} RouteParam;
+
+typedef struct {
+    int count;
+    RouteParam values[ROUTER_MAX_PARAMS];
+} RouteParams;
+
+typedef struct {
+    const char *segment;
+    size_t segment_len;
+    int is_param;
+    int first_child;
+    int next_sibling;
+    // Value given to router_add for each method, or -1.
+    int values[ROUTER_METHOD_COUNT];
+} RouterNode;
+
+typedef struct {
+    RouterNode nodes[ROUTER_MAX_NODES];
+    int node_count;
+} Router;
+
+void router_init(Router *router);
+/* pattern must outlive the router. Returns 0 if the pattern or method is unsupported or the trie is full. */
+int router_add(Router *router, const char *method, const char *pattern, int value);
+RouteResult router_match(const Router *router, const char *method, const char *path, int *value, RouteParams *params);
+
+/* Copies a parameter into out as a C string. Returns 0 if it does not fit. */
+int route_param_copy(const RouteParam *param, char *out, size_t out_size);
+
+#endif // ROUTER_H
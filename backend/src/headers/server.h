@@ -0,0 +1,37 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <pthread.h>
+
+#include "session.h"
+#include "lock_profile.h"
+#include "metrics.h"
+
+typedef struct {
+    SessionStore store;
+    ProfMutex mutex;
+} ServerState;
+
+extern ServerState server_state;
+
+static inline void record_server_state_lock(uint64_t wait_ns) {
+    if (wait_ns) metrics_add(METRIC_LOCK_CONTENDED, 1);
+    metrics_add(METRIC_LOCK_ACQUISITIONS, 1);
+    metrics_observe(METRIC_LOCK_WAIT, wait_ns);
+}
+
+/*
+    Takes server_state.mutex, timing the wait only when it is contended.
+    A macro so that lock profiling sees each caller as its own site.
+*/
+#define lock_server_state() do { \
+        uint64_t server_state_wait_ns_; \
+        PROF_MUTEX_LOCK(&server_state.mutex, &server_state_wait_ns_); \
+        record_server_state_lock(server_state_wait_ns_); \
+    } while (0)
+
+static inline void unlock_server_state(void) {
+    prof_mutex_unlock(&server_state.mutex);
+}
+
+#endif // SERVER_H
@@ -0,0 +1,127 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+
+#include "game.h"
+
+#define SESSION_ID_STR_LEN 37
+#define PLAYER_TOKEN_STR_LEN 33
+#define PLAYER_NAME_LEN 50
+
+struct lws;
+
+typedef enum {
+    WAITING_FOR_PLAYER,
+    IN_PROGRESS,
+    FINISHED,
+    // Slot of a removed session, waiting on the free list.
+    SESSION_FREE
+} GameState;
+
+typedef struct {
+    uint64_t hi;
+    uint64_t lo;
+} SessionId;
+
+typedef SessionId PlayerToken;
+
+/*
+    Hot part of a session: everything an attack reads or writes.
+    Kept apart from SessionInfo so a move touches only a few cache lines.
+*/
+typedef struct {
+    _Alignas(64) Board board1;
+    Board board2;
+    struct lws *ws1;
+    struct lws *ws2;
+    uint8_t state;
+    uint8_t current_player;
+    uint8_t variant;
+    uint8_t bot;
+    // Bumped on every change visible to clients: join, attack, leave, removal.
+    uint32_t move_seq;
+} GameSession;
+
+/* Cold part of a session, stored in a parallel array. */
+typedef struct {
+    SessionId id;
+    PlayerToken token1;
+    PlayerToken token2;
+    char player1[PLAYER_NAME_LEN];
+    char player2[PLAYER_NAME_LEN];
+    time_t created_at;
+} SessionInfo;
+
+typedef struct {
+    SessionId id;
+    int session_ind;
+} SessionIndexEntry;
+
+/*
+    Slots below session_count have been used; removed ones are SESSION_FREE
+    and listed in free_slots until create_session reuses them.
+*/
+typedef struct {
+    GameSession *sessions;
+    SessionInfo *infos;
+    SessionIndexEntry *index;
+    int *free_slots;
+    unsigned int index_mask;
+    int capacity;
+    int session_count;
+    int free_count;
+} SessionStore;
+
+static inline int session_id_equal(SessionId a, SessionId b) {
+    return a.hi == b.hi && a.lo == b.lo;
+}
+
+static inline int session_id_is_null(SessionId id) {
+    return (id.hi | id.lo) == 0;
+}
+
+static inline int player_token_matches(PlayerToken a, PlayerToken b) {
+    return ((a.hi ^ b.hi) | (a.lo ^ b.lo)) == 0;
+}
+
+static inline SessionInfo* session_info(SessionStore *store, const GameSession *session) {
+    return &store->infos[session - store->sessions];
+}
+
+/*
+    A session copied out while the store is locked, so frames can be built
+    and sent after unlocking. The slot may be reused by then; compare
+    info.id before relating it to a live session.
+*/
+typedef struct {
+    GameSession session;
+    SessionInfo info;
+    int slot;
+} SessionSnapshot;
+
+static inline void snapshot_session(SessionStore *store, const GameSession *session, SessionSnapshot *snapshot) {
+    snapshot->session = *session;
+    snapshot->info = *session_info(store, session);
+    snapshot->slot = (int)(session - store->sessions);
+}
+
+int fill_random(void *buf, size_t len);
+int generate_player_token(PlayerToken *token);
+void format_player_token(PlayerToken token, char *out);
+int parse_player_token(const char *str, PlayerToken *token);
+void format_session_id(SessionId id, char *out);
+int parse_session_id(const char *str, SessionId *id);
+
+int session_store_init(SessionStore *store, int capacity);
+void session_store_destroy(SessionStore *store);
+GameSession* find_session(SessionStore *store, SessionId session_id);
+GameSession* create_session(SessionStore *store, const char *player_name, int variant);
+int join_session(SessionStore *store, GameSession *session, const char *player_name);
+/* Frees the session's slot and id; pointers to it must be dropped first. */
+void remove_session(SessionStore *store, GameSession *session);
+int apply_attack(GameSession *session, int x, int y);
+
+#endif // SESSION_H
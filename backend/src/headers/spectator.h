@@ -0,0 +1,37 @@
+#ifndef SPECTATOR_H
+#define SPECTATOR_H
+
+#include "session.h"
+
+struct ws_client;
+
+/*
+    Spectators: sockets that sent {"type":"spectate"} for a session. They get
+    its public state on attach and again after every change. The state is
+    serialized once per change and the same WsPayload is queued on every
+    spectator. A socket holds at most SPECTATOR_QUEUE_LIMIT of these frames
+    and the oldest are dropped, so a slow spectator costs the players
+    nothing; frames it gets as a player are never dropped.
+
+    Lists are indexed like server_state.store.sessions and belong to the lws
+    thread; all functions here run on it.
+*/
+
+struct SpectatorList {
+    // Session the list watches; the slot may be reused after removal.
+    SessionId id;
+    struct ws_client *head;
+};
+
+/* Returns 0 if the session does not exist or out of memory. */
+int spectator_attach(struct lws *wsi, SessionId id);
+void spectator_detach(struct ws_client *client);
+/*
+    Sends the public state in snapshot to the session's spectators. Takes
+    no lock; the caller copies the session under server_state.mutex.
+*/
+void spectator_publish(const SessionSnapshot *snapshot);
+/* Tells spectators of removed sessions and detaches them. */
+void spectator_prune(void);
+
+#endif // SPECTATOR_H
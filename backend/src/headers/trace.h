@@ -0,0 +1,75 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "metrics.h"
+
+/*
+    Move tracing. Each thread appends finished spans to its own ring of the
+    last TRACE_RING_EVENTS spans, overwriting the oldest; nothing is
+    allocated or locked on the way. trace_write dumps all rings in Chrome
+    trace-event format (chrome://tracing, ui.perfetto.dev).
+
+    Spans belong to the move being handled by the thread, see
+    trace_begin_move. Outside a move, nothing is recorded.
+*/
+
+#define TRACE_RING_EVENTS 8192
+
+typedef struct {
+    const char *name;
+    uint64_t move_id;
+    uint64_t start_ns;
+    uint64_t end_ns;
+} TraceEvent;
+
+typedef struct TraceRing {
+    struct TraceRing *next;
+    atomic_int in_use;
+    int thread_slot;
+    _Atomic uint64_t head;
+    TraceEvent events[TRACE_RING_EVENTS];
+} TraceRing;
+
+extern _Thread_local TraceRing *trace_thread_ring;
+extern _Thread_local uint64_t trace_current_move;
+
+TraceRing* trace_attach_thread(void);
+
+/* Starts a move on this thread and returns its id. */
+uint64_t trace_begin_move(void);
+
+static inline void trace_end_move(void) {
+    trace_current_move = 0;
+}
+
+static inline void trace_record(const char *name, uint64_t move_id, uint64_t start_ns, uint64_t end_ns) {
+    if (!move_id) return;
+
+    TraceRing *ring = trace_thread_ring ? trace_thread_ring : trace_attach_thread();
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    TraceEvent *event = &ring->events[head % TRACE_RING_EVENTS];
+    event->name = name;
+    event->move_id = move_id;
+    event->start_ns = start_ns;
+    event->end_ns = end_ns;
+
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+/* Records a span of the current move that started at start_ns and ends now. */
+static inline void trace_span(const char *name, uint64_t start_ns) {
+    if (!trace_current_move) return;
+    trace_record(name, trace_current_move, start_ns, metrics_now_ns());
+}
+
+void trace_write(FILE *out);
+
+/* Writes the trace to path. Returns 0 on failure. */
+int trace_dump_file(const char *path);
+
+#endif // TRACE_H
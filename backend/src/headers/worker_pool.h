@@ -0,0 +1,15 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+typedef void (*worker_job_fn)(void *arg);
+
+typedef struct WorkerPool WorkerPool;
+
+WorkerPool* worker_pool_create(int thread_count);
+void worker_pool_destroy(WorkerPool *pool);
+int worker_pool_size(const WorkerPool *pool);
+
+/* Queues a job; never waits for a worker. Returns 0 if out of memory. */
+int worker_pool_submit(WorkerPool *pool, worker_job_fn fn, void *arg);
+
+#endif // WORKER_POOL_H
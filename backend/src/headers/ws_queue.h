@@ -0,0 +1,57 @@
+#ifndef WS_QUEUE_H
+#define WS_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Max spectator frames queued to a socket; older ones are dropped, as each is a full snapshot.
+#define SPECTATOR_QUEUE_LIMIT 4
+
+/*
+    Text of an outgoing frame, shared by every queue it is on, so a message
+    fanned out to many sockets is stored once. LWS_PRE bytes of headroom
+    precede the text; lws_write scribbles there, which is safe because all
+    writes happen one at a time on the lws thread. Used on that thread only.
+*/
+typedef struct {
+    int refs;
+    size_t len;
+    unsigned char data[];
+} WsPayload;
+
+typedef struct WsFrame {
+    struct WsFrame *next;
+    WsPayload *payload;
+    // Traced move that queued the frame, 0 if none.
+    uint64_t move_id;
+    uint64_t queued_ns;
+    // Spectator snapshots may be dropped for newer ones; no other frame is.
+    int is_spectator;
+} WsFrame;
+
+/*
+    Frames waiting to be written to one socket, oldest first. A socket that
+    plays and spectates has one queue for both, so spectator_depth counts
+    the spectator frames on their own.
+*/
+typedef struct {
+    WsFrame *head;
+    WsFrame *tail;
+    int depth;
+    int spectator_depth;
+} WsSendQueue;
+
+void ws_payload_release(WsPayload *payload);
+
+/* Appends payload, taking a reference. Returns 0 if out of memory. */
+int ws_queue_push(WsSendQueue *queue, WsPayload *payload, int is_spectator, uint64_t move_id, uint64_t queued_ns);
+/* Unlinks the oldest frame, NULL if empty. The caller releases its payload and frees it. */
+WsFrame* ws_queue_pop(WsSendQueue *queue);
+/*
+    Drops the oldest spectator frames until fewer than limit are queued,
+    making room for a new one. Returns how many were dropped.
+*/
+int ws_queue_trim_spectator(WsSendQueue *queue, int limit);
+void ws_queue_clear(WsSendQueue *queue);
+
+#endif // WS_QUEUE_H
@@ -0,0 +1,90 @@
+#ifndef WS_SERVER_H
+#define WS_SERVER_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <libwebsockets.h>
+
+#include "session.h"
+#include "worker_pool.h"
+#include "ws_queue.h"
+
+// Sessions one connection may hold seats in.
+#define WS_MAX_SEATS 1024
+
+typedef struct SpectatorList SpectatorList;
+
+// A player's place in one session. session is NULL once the session is removed.
+typedef struct {
+    GameSession *session;
+    SessionId id;
+    int player_num;
+} WsSeat;
+
+/*
+    One connection can play many sessions at once. It holds a seat in each,
+    every frame it gets about a session is tagged with "session_id", and
+    all of them share its one send queue. Seats are guarded by
+    server_state.mutex.
+*/
+struct ws_client {
+    struct lws *wsi;
+    WsSeat *seats;
+    int seat_count;
+    int seat_cap;
+    WsSendQueue send_queue;
+    // Set when a seat's session is removed from another thread; reported on the next write.
+    atomic_int session_closed;
+    // Session being watched, and neighbours in its list of spectators.
+    SpectatorList *spectating;
+    struct ws_client *spectator_prev;
+    struct ws_client *spectator_next;
+};
+
+extern struct lws_protocols protocols[];
+
+// Hard-bot searches run on bot_pool and wake the service loop of ws_context.
+extern WorkerPool *bot_pool;
+extern struct lws_context *ws_context;
+
+void send_ws_message(struct lws *wsi, const char *message);
+/* Sends a JSON object message with "session_id" added as its first field. */
+void send_session_message(struct lws *wsi, SessionId session_id, const char *message);
+/* A payload with one reference, held by the caller. */
+WsPayload* ws_payload_create(const char *message);
+WsPayload* ws_payload_create_tagged(const char *message, SessionId session_id);
+/* Queues payload on wsi, taking a reference. */
+void send_ws_payload(struct lws *wsi, WsPayload *payload);
+/*
+    Queues a spectator snapshot on wsi, dropping its oldest queued snapshots
+    past SPECTATOR_QUEUE_LIMIT. Frames the socket gets as a player or lobby
+    subscriber are never dropped. Returns how many were dropped.
+*/
+int send_spectator_payload(struct lws *wsi, WsPayload *payload);
+void send_game_state(GameSession *session, int player_num);
+/*
+    Called with server_state.mutex held, on the lws thread. Seats wsi as
+    player_num; a previous socket in that seat is sent seat_taken and
+    detached. Returns 0 if the connection is out of seats.
+*/
+int bind_ws_client(struct lws *wsi, GameSession *session, int player_num);
+/*
+    Called with server_state.mutex held, on the lws thread. Undoes
+    bind_ws_client, e.g. before removing a session no one was told about.
+*/
+void unbind_ws_seat(struct lws *wsi, GameSession *session, int player_num);
+/* Called with server_state.mutex held, from any thread, before the session is removed. */
+void close_session_clients(GameSession *session);
+/* Wakes the service loop to tell the clients detached by close_session_clients. */
+void notify_closed_sessions(void);
+
+/*
+    wsi - ptr on websocket connection 
+    reason - reason of call
+    user - user data
+    in - input data
+    len - input data len
+*/
+int callback_battleship(struct lws *wsi, enum lws_callback_reasons reason, void *user, void *in, size_t len);
+
+#endif // WS_SERVER_H
@@ -0,0 +1,56 @@
+#include <string.h>
+
+#include "histogram.h"
+
+void histogram_init(Histogram *histogram) {
+    memset(histogram, 0, sizeof(Histogram));
+    histogram->min = UINT64_MAX;
+}
+
+void histogram_record(Histogram *histogram, uint64_t value) {
+    histogram->buckets[histogram_bucket(value)]++;
+    histogram->count++;
+    histogram->total += value;
+
+    if (value < histogram->min) histogram->min = value;
+    if (value > histogram->max) histogram->max = value;
+}
+
+void histogram_merge(Histogram *dst, const Histogram *src) {
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        dst->buckets[i] += src->buckets[i];
+    }
+
+    dst->count += src->count;
+    dst->total += src->total;
+
+    if (src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+uint64_t histogram_percentile(const Histogram *histogram, double fraction) {
+    if (histogram->count == 0) return 0;
+
+    uint64_t rank = (uint64_t)(fraction * (double)(histogram->count - 1));
+    uint64_t seen = 0;
+
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += histogram->buckets[i];
+        if (seen > rank) {
+            // Middle of the bucket, clamped to what was actually recorded.
+            uint64_t lower = histogram_bucket_lower_bound(i);
+            uint64_t upper = (i + 1 < HISTOGRAM_BUCKETS) ? histogram_bucket_lower_bound(i + 1) - 1 : UINT64_MAX;
+            uint64_t value = lower + (upper - lower) / 2;
+
+            if (value < histogram->min) value = histogram->min;
+            if (value > histogram->max) value = histogram->max;
+            return value;
+        }
+    }
+
+    return histogram->max;
+}
+
+double histogram_mean(const Histogram *histogram) {
+    return histogram->count ? (double)histogram->total / histogram->count : 0.0;
+}
@@ -0,0 +1,1060 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include <jansson.h>
+
+#include "http_server.h"
+#include "server.h"
+#include "protocol.h"
+#include "bot.h"
+#include "metrics.h"
+#include "trace.h"
+#include "router.h"
+#include "ws_server.h"
+#include "matchmaking.h"
+#include "lobby.h"
+
+#define POOL_EMPTY UINT32_MAX
+
+// Status of the response queued by the current request, for the metrics.
+static _Thread_local int response_status;
+
+typedef struct {
+    int status_code;
+    const char *body;
+} ErrorReply;
+
+static const ErrorReply error_replies[HTTP_ERROR_COUNT] = {
+    [HTTP_ERROR_NOT_FOUND] = { MHD_HTTP_NOT_FOUND, "{\"error\":\"Not Found\"}" },
+    [HTTP_ERROR_METHOD_NOT_ALLOWED] = { MHD_HTTP_METHOD_NOT_ALLOWED, "{\"error\":\"Method not allowed\"}" },
+    [HTTP_ERROR_UNAUTHORIZED] = { MHD_HTTP_UNAUTHORIZED, "{\"error\":\"Missing or malformed token\"}" },
+    [HTTP_ERROR_FORBIDDEN] = { MHD_HTTP_FORBIDDEN, "{\"error\":\"Token does not match\"}" },
+    [HTTP_ERROR_INVALID_JSON] = { MHD_HTTP_BAD_REQUEST, "{\"error\":\"Invalid JSON\"}" },
+    [HTTP_ERROR_MISSING_FIELDS] = { MHD_HTTP_BAD_REQUEST, "{\"error\":\"Missing fields\"}" },
+    [HTTP_ERROR_MISSING_PLAYER_NAME] = { MHD_HTTP_BAD_REQUEST, "{\"error\":\"Missing player_name\"}" },
+    [HTTP_ERROR_UNKNOWN_VARIANT] = { MHD_HTTP_BAD_REQUEST, "{\"error\":\"Unknown variant\"}" },
+    [HTTP_ERROR_UNKNOWN_OPPONENT] = { MHD_HTTP_BAD_REQUEST, "{\"error\":\"Unknown opponent\"}" },
+    [HTTP_ERROR_UNKNOWN_DIFFICULTY] = { MHD_HTTP_BAD_REQUEST, "{\"error\":\"Unknown difficulty\"}" },
+    [HTTP_ERROR_CANNOT_JOIN] = { MHD_HTTP_BAD_REQUEST, "{\"error\":\"Cannot join session\"}" },
+    [HTTP_ERROR_PAYLOAD_TOO_LARGE] = { MHD_HTTP_CONTENT_TOO_LARGE, "{\"error\":\"Payload too large\"}" },
+    [HTTP_ERROR_MAX_SESSIONS] = { MHD_HTTP_SERVICE_UNAVAILABLE, "{\"error\":\"Max sessions reached\"}" },
+    [HTTP_ERROR_QUICKMATCH_FULL] = { MHD_HTTP_SERVICE_UNAVAILABLE, "{\"error\":\"Too many quick-match tickets\"}" },
+    [HTTP_ERROR_INTERNAL] = { MHD_HTTP_INTERNAL_SERVER_ERROR, "{\"error\":\"Internal server error\"}" },
+};
+
+// Built once by http_server_init and queued on any number of connections.
+static struct MHD_Response *error_responses[HTTP_ERROR_COUNT];
+static struct MHD_Response *no_content_response;
+
+typedef int (*HttpHandler)(struct MHD_Connection *connection, const struct connection_info *con_info, const RouteParams *params);
+
+typedef struct {
+    const char *method;
+    const char *pattern;
+    HttpRoute metric;
+    HttpHandler handler;
+} HttpRouteEntry;
+
+static Router router;
+
+/*
+    Serialized public state of a session at one move_seq. The cache holds
+    one reference and every response being sent holds another, so a text
+    replaced in the cache lives until MHD has finished sending it.
+*/
+typedef struct {
+    atomic_int refs;
+    SessionId id;
+    uint32_t move_seq;
+    size_t len;
+    char data[];
+} PublicState;
+
+// Indexed like server_state.store.sessions; guarded by server_state.mutex.
+static PublicState **public_states;
+
+typedef struct {
+    SessionId id;
+    char player1[PLAYER_NAME_LEN];
+    char player2[PLAYER_NAME_LEN];
+    time_t created_at;
+    uint8_t state;
+    uint8_t variant;
+    uint8_t bot;
+    uint32_t move_seq;
+} SessionListEntry;
+
+/*
+    State of one streamed session listing. Sessions are copied out of the
+    store a batch at a time and serialized into pending one entry at a
+    time, so the response never holds more than a batch and an entry.
+*/
+typedef struct {
+    int waiting_only;
+    int next_slot;
+    int scan_done;
+    int closed;
+    int entries_written;
+    int batch_count;
+    int batch_next;
+    size_t pending_len;
+    size_t pending_off;
+    char pending[1024];
+    SessionListEntry batch[SESSION_STREAM_BATCH];
+} SessionStream;
+
+/*
+    Free slots form a stack linked through pool_next. The head packs the
+    top slot with a tag bumped on every push, so a pop that raced with a
+    pop and push of the same slot fails its CAS instead of corrupting the
+    stack. Slots that were never used are handed out by pool_unused first.
+*/
+static struct connection_info connection_pool[CONNECTION_POOL_SIZE];
+static _Atomic uint32_t pool_next[CONNECTION_POOL_SIZE];
+static _Atomic uint64_t pool_head = POOL_EMPTY;
+static _Atomic uint32_t pool_unused;
+
+
+
+static int pool_pop(void) {
+    uint64_t head = atomic_load_explicit(&pool_head, memory_order_acquire);
+
+    while ((uint32_t)head != POOL_EMPTY) {
+        uint32_t slot = (uint32_t)head;
+        uint64_t next = (head & ~(uint64_t)UINT32_MAX) | atomic_load_explicit(&pool_next[slot], memory_order_relaxed);
+
+        if (atomic_compare_exchange_weak_explicit(&pool_head, &head, next, memory_order_acquire, memory_order_acquire)) {
+            return (int)slot;
+        }
+    }
+
+    if (atomic_load_explicit(&pool_unused, memory_order_relaxed) < CONNECTION_POOL_SIZE) {
+        uint32_t slot = atomic_fetch_add_explicit(&pool_unused, 1, memory_order_relaxed);
+        if (slot < CONNECTION_POOL_SIZE) return (int)slot;
+    }
+
+    return -1;
+}
+
+static void pool_push(int slot) {
+    uint64_t head = atomic_load_explicit(&pool_head, memory_order_relaxed);
+    uint64_t next;
+
+    do {
+        atomic_store_explicit(&pool_next[slot], (uint32_t)head, memory_order_relaxed);
+        next = ((head >> 32) + 1) << 32 | (uint32_t)slot;
+    } while (!atomic_compare_exchange_weak_explicit(&pool_head, &head, next, memory_order_release, memory_order_relaxed));
+}
+
+struct connection_info* connection_info_create(size_t expected_size) {
+    int slot = pool_pop();
+    struct connection_info *con_info = slot >= 0 ? &connection_pool[slot] : malloc(sizeof(struct connection_info));
+    if (!con_info) return NULL;
+
+    arena_init(&con_info->arena, con_info->arena_initial, sizeof(con_info->arena_initial));
+    con_info->upload_data = NULL;
+    con_info->upload_data_size = 0;
+    con_info->upload_data_cap = 0;
+    con_info->too_large = 0;
+    con_info->pool_slot = slot;
+
+    if (expected_size > 0 && expected_size <= MHD_MAX_JSON_SIZE) {
+        con_info->upload_data = arena_alloc(&con_info->arena, expected_size);
+        con_info->upload_data_cap = con_info->upload_data ? expected_size : 0;
+    }
+
+    return con_info;
+}
+
+int connection_info_append(struct connection_info *con_info, const char *data, size_t size) {
+    size_t needed = con_info->upload_data_size + size;
+
+    if (con_info->too_large || needed > MHD_MAX_JSON_SIZE) {
+        con_info->too_large = 1;
+        return 1;
+    }
+
+    if (needed > con_info->upload_data_cap) {
+        size_t cap = con_info->upload_data_cap ? con_info->upload_data_cap * 2 : 1024;
+        while (cap < needed) cap *= 2;
+
+        char *new_data = arena_grow(&con_info->arena, con_info->upload_data, con_info->upload_data_size, cap);
+        if (!new_data) {
+            return 0;
+        }
+        con_info->upload_data = new_data;
+        con_info->upload_data_cap = cap;
+    }
+
+    memcpy(con_info->upload_data + con_info->upload_data_size, data, size);
+    con_info->upload_data_size += size;
+
+    return 1;
+}
+
+void connection_info_free(struct connection_info *con_info) {
+    arena_reset(&con_info->arena);
+
+    if (con_info->pool_slot >= 0) {
+        pool_push(con_info->pool_slot);
+    } else {
+        free(con_info);
+    }
+}
+
+
+
+int queue_response(struct MHD_Connection *connection, int status_code, struct MHD_Response *response) {
+    response_status = status_code;
+    return MHD_queue_response(connection, status_code, response);
+}
+
+int send_error(struct MHD_Connection *connection, HttpError error) {
+    return queue_response(connection, error_replies[error].status_code, error_responses[error]);
+}
+
+int handle_join_session(struct MHD_Connection *connection, const struct connection_info *con_info, const RouteParams *params) {
+    (void)params;
+
+    json_error_t error;
+    json_t *root = json_loadb(con_info->upload_data, con_info->upload_data_size, 0, &error);
+    if (!root) {
+        return send_error(connection, HTTP_ERROR_INVALID_JSON);
+    }
+
+    json_t *session_id_json = json_object_get(root, "session_id");
+    json_t *player_name_json = json_object_get(root, "player_name");
+
+    if (!json_is_string(session_id_json) || !json_is_string(player_name_json)) {
+        json_decref(root);
+        return send_error(connection, HTTP_ERROR_MISSING_FIELDS);
+    }
+
+    const char *player_name = json_string_value(player_name_json);
+
+    SessionId session_id;
+    int is_player_joined = 0;
+    SessionInfo info;
+    Board board;
+    int variant = 0;
+
+    // Copied under the lock: the session may be removed once it is released.
+    if (parse_session_id(json_string_value(session_id_json), &session_id)) {
+        lock_server_state();
+        GameSession *session = find_session(&server_state.store, session_id);
+        is_player_joined = session ? join_session(&server_state.store, session, player_name) : 0;
+        if (is_player_joined) {
+            info = *session_info(&server_state.store, session);
+            lobby_session_removed(info.id);
+            board = session->board2;
+            variant = session->variant;
+        }
+        unlock_server_state();
+    }
+
+    if (!is_player_joined) {
+        json_decref(root);
+        return send_error(connection, HTTP_ERROR_CANNOT_JOIN);
+    }
+
+    char session_id_str[SESSION_ID_STR_LEN];
+    format_session_id(info.id, session_id_str);
+
+    char token_str[PLAYER_TOKEN_STR_LEN];
+    format_player_token(info.token2, token_str);
+
+    json_t *response = json_object();
+    json_object_set_new(response, "session_id", json_string(session_id_str));
+    json_object_set_new(response, "token", json_string(token_str));
+    json_object_set_new(response, "player", json_string("Player 2"));
+    json_object_set_new(response, "variant", json_string(game_variants[variant].name));
+    json_object_set_new(response, "board", serialize_board(&board));
+
+    char *response_str = dump_json(response);
+    json_decref(response);
+    json_decref(root);
+
+    struct MHD_Response *mhd_response = MHD_create_response_from_buffer(
+        strlen(response_str), 
+        (void*)response_str, 
+        MHD_RESPMEM_MUST_FREE
+    );
+
+    if (!mhd_response) {
+        free(response_str);
+        return send_error(connection, HTTP_ERROR_INTERNAL);
+    }
+
+    MHD_add_response_header(mhd_response, "Content-Type", "application/json");
+
+    int ret = queue_response(connection, MHD_HTTP_OK, mhd_response);
+    
+    MHD_destroy_response(mhd_response);
+
+    return ret;
+}
+
+int handle_create_session(struct MHD_Connection *connection, const struct connection_info *con_info, const RouteParams *params) {
+    (void)params;
+
+    json_error_t error;
+    json_t *root = json_loadb(con_info->upload_data, con_info->upload_data_size, 0, &error);
+    if (!root) {
+        return send_error(connection, HTTP_ERROR_INVALID_JSON);
+    }
+
+    json_t *player_name_json = json_object_get(root, "player_name");
+    if (!json_is_string(player_name_json)) {
+        json_decref(root);
+        return send_error(connection, HTTP_ERROR_MISSING_PLAYER_NAME);
+    }
+
+    const char *player_name = json_string_value(player_name_json);
+
+    int variant = VARIANT_CLASSIC;
+    json_t *variant_json = json_object_get(root, "variant");
+    if (variant_json) {
+        variant = json_is_string(variant_json) ? find_game_variant(json_string_value(variant_json)) : -1;
+        if (variant < 0) {
+            json_decref(root);
+            return send_error(connection, HTTP_ERROR_UNKNOWN_VARIANT);
+        }
+    }
+
+    BotKind bot = BOT_NONE;
+    json_t *opponent_json = json_object_get(root, "opponent");
+    if (opponent_json) {
+        if (!json_is_string(opponent_json) ||
+            (strcmp(json_string_value(opponent_json), "bot") != 0 && strcmp(json_string_value(opponent_json), "human") != 0)) {
+            json_decref(root);
+            return send_error(connection, HTTP_ERROR_UNKNOWN_OPPONENT);
+        }
+        if (strcmp(json_string_value(opponent_json), "bot") == 0) {
+            bot = BOT_DENSITY;
+        }
+    }
+
+    json_t *difficulty_json = json_object_get(root, "difficulty");
+    if (difficulty_json) {
+        if (!json_is_string(difficulty_json) ||
+            (strcmp(json_string_value(difficulty_json), "normal") != 0 && strcmp(json_string_value(difficulty_json), "hard") != 0)) {
+            json_decref(root);
+            return send_error(connection, HTTP_ERROR_UNKNOWN_DIFFICULTY);
+        }
+        if (bot != BOT_NONE && strcmp(json_string_value(difficulty_json), "hard") == 0) {
+            bot = BOT_MONTE_CARLO;
+        }
+    }
+
+    SessionInfo info;
+    Board board;
+
+    lock_server_state();
+    GameSession *session = create_session(&server_state.store, player_name, variant);
+    if (session && bot != BOT_NONE && !attach_bot(&server_state.store, session, bot)) {
+        remove_session(&server_state.store, session);
+        session = NULL;
+    }
+    if (session) {
+        info = *session_info(&server_state.store, session);
+        board = session->board1;
+        if (session->state == WAITING_FOR_PLAYER) {
+            lobby_session_added(session, &info);
+        }
+    }
+    unlock_server_state();
+
+    if (!session) {
+        json_decref(root);
+        return send_error(connection, HTTP_ERROR_MAX_SESSIONS);
+    }
+
+    char session_id_str[SESSION_ID_STR_LEN];
+    format_session_id(info.id, session_id_str);
+
+    char token_str[PLAYER_TOKEN_STR_LEN];
+    format_player_token(info.token1, token_str);
+
+    json_t *response = json_object();
+    json_object_set_new(response, "session_id", json_string(session_id_str));
+    json_object_set_new(response, "token", json_string(token_str));
+    json_object_set_new(response, "player", json_string("Player 1"));
+    json_object_set_new(response, "variant", json_string(game_variants[variant].name));
+    json_object_set_new(response, "board", serialize_board(&board));
+
+    char *response_str = dump_json(response);
+    json_decref(response);
+    json_decref(root);
+
+    struct MHD_Response *mhd_response = MHD_create_response_from_buffer(
+        strlen(response_str), 
+        (void*)response_str, 
+        MHD_RESPMEM_MUST_FREE
+    );
+
+    if (!mhd_response) {
+        free(response_str);
+        return send_error(connection, HTTP_ERROR_INTERNAL);
+    }
+
+    MHD_add_response_header(mhd_response, "Content-Type", "application/json");
+    
+    int ret = queue_response(connection, MHD_HTTP_OK, mhd_response);
+    
+    MHD_destroy_response(mhd_response);
+
+    return ret;
+}
+
+static void public_state_release(PublicState *state) {
+    if (state && atomic_fetch_sub(&state->refs, 1) == 1) {
+        free(state);
+    }
+}
+
+// MHD free callback: cls is the data member of a PublicState.
+static void public_state_release_data(void *cls) {
+    public_state_release((PublicState *)((char *)cls - offsetof(PublicState, data)));
+}
+
+/* Called with server_state.mutex held. */
+static void drop_public_state(int slot) {
+    public_state_release(public_states[slot]);
+    public_states[slot] = NULL;
+}
+
+static PublicState* public_state_create(const GameSession *session, const SessionInfo *info) {
+    char *text = build_public_state_message(session, info);
+    if (!text) return NULL;
+
+    size_t len = strlen(text);
+    PublicState *state = malloc(sizeof(PublicState) + len);
+    if (state) {
+        atomic_init(&state->refs, 1);
+        state->id = info->id;
+        state->move_seq = session->move_seq;
+        state->len = len;
+        memcpy(state->data, text, len);
+    }
+
+    free(text);
+    return state;
+}
+
+/*
+    The ETag is the session's move_seq, so a poller whose game has not moved
+    gets 304 without any serialization. Otherwise the cached text for the
+    current move_seq is shared; on a miss the session is copied under the
+    lock, serialized outside it and cached if the game has not moved since.
+*/
+int handle_get_session(struct MHD_Connection *connection, const struct connection_info *con_info, const RouteParams *params) {
+    (void)con_info;
+
+    char session_id_str[SESSION_ID_STR_LEN];
+    SessionId session_id;
+    if (!route_param_copy(&params->values[0], session_id_str, sizeof(session_id_str)) ||
+        !parse_session_id(session_id_str, &session_id)) {
+        return send_error(connection, HTTP_ERROR_NOT_FOUND);
+    }
+
+    const char *if_none_match = MHD_lookup_connection_value(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_IF_NONE_MATCH);
+
+    GameSession snapshot;
+    SessionInfo info;
+    PublicState *state = NULL;
+
+    lock_server_state();
+
+    GameSession *session = find_session(&server_state.store, session_id);
+    if (!session) {
+        unlock_server_state();
+        return send_error(connection, HTTP_ERROR_NOT_FOUND);
+    }
+
+    int slot = (int)(session - server_state.store.sessions);
+    uint32_t move_seq = session->move_seq;
+
+    char etag[16];
+    snprintf(etag, sizeof(etag), "\"%" PRIu32 "\"", move_seq);
+
+    if (if_none_match && strcmp(if_none_match, etag) == 0) {
+        unlock_server_state();
+
+        struct MHD_Response *mhd_response = MHD_create_response_from_buffer(0, (void *)"", MHD_RESPMEM_PERSISTENT);
+        if (!mhd_response) {
+            return send_error(connection, HTTP_ERROR_INTERNAL);
+        }
+        MHD_add_response_header(mhd_response, MHD_HTTP_HEADER_ETAG, etag);
+        MHD_add_response_header(mhd_response, MHD_HTTP_HEADER_CACHE_CONTROL, "no-cache");
+
+        int ret = queue_response(connection, MHD_HTTP_NOT_MODIFIED, mhd_response);
+        MHD_destroy_response(mhd_response);
+        return ret;
+    }
+
+    PublicState *cached = public_states[slot];
+    if (cached && cached->move_seq == move_seq && session_id_equal(cached->id, session_id)) {
+        atomic_fetch_add(&cached->refs, 1);
+        state = cached;
+    } else {
+        snapshot = *session;
+        info = *session_info(&server_state.store, session);
+    }
+
+    unlock_server_state();
+
+    if (!state) {
+        state = public_state_create(&snapshot, &info);
+        if (!state) {
+            return send_error(connection, HTTP_ERROR_INTERNAL);
+        }
+
+        lock_server_state();
+        session = &server_state.store.sessions[slot];
+        if (session->move_seq == move_seq && session_id_equal(session_info(&server_state.store, session)->id, session_id)) {
+            drop_public_state(slot);
+            atomic_fetch_add(&state->refs, 1);
+            public_states[slot] = state;
+        }
+        unlock_server_state();
+    }
+
+    struct MHD_Response *mhd_response = MHD_create_response_from_buffer_with_free_callback(
+        state->len, state->data, public_state_release_data);
+
+    if (!mhd_response) {
+        public_state_release(state);
+        return send_error(connection, HTTP_ERROR_INTERNAL);
+    }
+
+    MHD_add_response_header(mhd_response, "Content-Type", "application/json");
+    MHD_add_response_header(mhd_response, MHD_HTTP_HEADER_ETAG, etag);
+    MHD_add_response_header(mhd_response, MHD_HTTP_HEADER_CACHE_CONTROL, "no-cache");
+
+    int ret = queue_response(connection, MHD_HTTP_OK, mhd_response);
+    MHD_destroy_response(mhd_response);
+
+    return ret;
+}
+
+static void session_stream_free(void *cls) {
+    free(cls);
+}
+
+/* Copies the next listed sessions out of the store; the lock is held for at most SESSION_STREAM_SCAN slots. */
+static void session_stream_refill(SessionStream *stream) {
+    stream->batch_count = 0;
+    stream->batch_next = 0;
+
+    lock_server_state();
+
+    int count = server_state.store.session_count;
+    int scan_end = stream->next_slot + SESSION_STREAM_SCAN;
+    while (stream->next_slot < count && stream->next_slot < scan_end && stream->batch_count < SESSION_STREAM_BATCH) {
+        int slot = stream->next_slot++;
+        GameSession *session = &server_state.store.sessions[slot];
+
+        if (session->state == SESSION_FREE || (stream->waiting_only && session->state != WAITING_FOR_PLAYER)) {
+            continue;
+        }
+
+        SessionInfo *info = &server_state.store.infos[slot];
+        SessionListEntry *entry = &stream->batch[stream->batch_count++];
+
+        entry->id = info->id;
+        memcpy(entry->player1, info->player1, sizeof(entry->player1));
+        memcpy(entry->player2, info->player2, sizeof(entry->player2));
+        entry->created_at = info->created_at;
+        entry->state = session->state;
+        entry->variant = session->variant;
+        entry->bot = session->bot;
+        entry->move_seq = session->move_seq;
+    }
+
+    if (stream->next_slot >= count) {
+        stream->scan_done = 1;
+    }
+
+    unlock_server_state();
+}
+
+/* Serializes one entry into stream->pending, preceded by a comma unless it is the first. */
+static int session_stream_format(SessionStream *stream, const SessionListEntry *entry) {
+    static const char *state_names[] = { "waiting", "in_progress", "finished" };
+
+    char session_id_str[SESSION_ID_STR_LEN];
+    format_session_id(entry->id, session_id_str);
+
+    json_t *session_obj = json_object();
+    json_object_set_new(session_obj, "id", json_string(session_id_str));
+    json_object_set_new(session_obj, "player1", json_string(entry->player1));
+    json_object_set_new(session_obj, "created_at", json_integer(entry->created_at));
+    json_object_set_new(session_obj, "variant", json_string(game_variants[entry->variant].name));
+    json_object_set_new(session_obj, "board_size", json_integer(game_variants[entry->variant].board_size));
+    if (!stream->waiting_only) {
+        json_object_set_new(session_obj, "player2", json_string(entry->player2));
+        json_object_set_new(session_obj, "state", json_string(state_names[entry->state]));
+        json_object_set_new(session_obj, "bot", json_integer(entry->bot));
+        json_object_set_new(session_obj, "move_seq", json_integer(entry->move_seq));
+    }
+
+    size_t offset = stream->entries_written ? 1 : 0;
+    size_t len = json_dumpb(session_obj, stream->pending + offset, sizeof(stream->pending) - offset, JSON_COMPACT);
+    json_decref(session_obj);
+
+    if (len == 0 || len > sizeof(stream->pending) - offset) {
+        return 0;
+    }
+
+    if (offset) stream->pending[0] = ',';
+    stream->pending_len = offset + len;
+    stream->pending_off = 0;
+    stream->entries_written++;
+    return 1;
+}
+
+/*
+    MHD content reader: fills buf with as much of the array as fits. The
+    listing is a weak snapshot; sessions created or removed while it
+    streams may or may not appear.
+*/
+static ssize_t session_stream_read(void *cls, uint64_t pos, char *buf, size_t max) {
+    (void)pos;
+    SessionStream *stream = cls;
+    size_t written = 0;
+
+    while (written < max) {
+        if (stream->pending_off < stream->pending_len) {
+            size_t chunk = stream->pending_len - stream->pending_off;
+            if (chunk > max - written) chunk = max - written;
+
+            memcpy(buf + written, stream->pending + stream->pending_off, chunk);
+            stream->pending_off += chunk;
+            written += chunk;
+        } else if (stream->batch_next < stream->batch_count) {
+            if (!session_stream_format(stream, &stream->batch[stream->batch_next++])) {
+                return MHD_CONTENT_READER_END_WITH_ERROR;
+            }
+        } else if (!stream->scan_done) {
+            session_stream_refill(stream);
+        } else if (!stream->closed) {
+            buf[written++] = ']';
+            stream->closed = 1;
+        } else {
+            break;
+        }
+    }
+
+    return written > 0 ? (ssize_t)written : MHD_CONTENT_READER_END_OF_STREAM;
+}
+
+/* Streams the session list as a JSON array; memory stays constant however many sessions there are. */
+static int send_session_stream(struct MHD_Connection *connection, int waiting_only) {
+    SessionStream *stream = malloc(sizeof(SessionStream));
+    if (!stream) {
+        return send_error(connection, HTTP_ERROR_INTERNAL);
+    }
+
+    memset(stream, 0, offsetof(SessionStream, batch));
+    stream->waiting_only = waiting_only;
+    stream->pending[0] = '[';
+    stream->pending_len = 1;
+
+    struct MHD_Response *mhd_response = MHD_create_response_from_callback(
+        MHD_SIZE_UNKNOWN, SESSION_STREAM_BLOCK_SIZE, session_stream_read, stream, session_stream_free);
+
+    if (!mhd_response) {
+        free(stream);
+        return send_error(connection, HTTP_ERROR_INTERNAL);
+    }
+
+    MHD_add_response_header(mhd_response, "Content-Type", "application/json");
+
+    int ret = queue_response(connection, MHD_HTTP_OK, mhd_response);
+    MHD_destroy_response(mhd_response);
+
+    return ret;
+}
+
+/*
+    Hands out a ticket for the quick-match queue. The player starts waiting
+    once a socket sends {"type":"quickmatch","ticket":...}; the pairing
+    and the session id arrive over that socket.
+*/
+int handle_quickmatch(struct MHD_Connection *connection, const struct connection_info *con_info, const RouteParams *params) {
+    (void)params;
+
+    json_error_t error;
+    json_t *root = json_loadb(con_info->upload_data, con_info->upload_data_size, 0, &error);
+    if (!root) {
+        return send_error(connection, HTTP_ERROR_INVALID_JSON);
+    }
+
+    json_t *player_name_json = json_object_get(root, "player_name");
+    if (!json_is_string(player_name_json)) {
+        json_decref(root);
+        return send_error(connection, HTTP_ERROR_MISSING_PLAYER_NAME);
+    }
+
+    int variant = VARIANT_CLASSIC;
+    json_t *variant_json = json_object_get(root, "variant");
+    if (variant_json) {
+        variant = json_is_string(variant_json) ? find_game_variant(json_string_value(variant_json)) : -1;
+        if (variant < 0) {
+            json_decref(root);
+            return send_error(connection, HTTP_ERROR_UNKNOWN_VARIANT);
+        }
+    }
+
+    PlayerToken ticket;
+    QuickmatchResult registered = quickmatch_register(json_string_value(player_name_json), variant, &ticket);
+    json_decref(root);
+
+    if (registered == QUICKMATCH_FULL) {
+        return send_error(connection, HTTP_ERROR_QUICKMATCH_FULL);
+    }
+    if (registered != QUICKMATCH_REGISTERED) {
+        return send_error(connection, HTTP_ERROR_INTERNAL);
+    }
+
+    char ticket_str[PLAYER_TOKEN_STR_LEN];
+    format_player_token(ticket, ticket_str);
+
+    json_t *response = json_object();
+    json_object_set_new(response, "ticket", json_string(ticket_str));
+    json_object_set_new(response, "variant", json_string(game_variants[variant].name));
+    json_object_set_new(response, "expires_in", json_integer(QUICKMATCH_TICKET_TTL));
+
+    char *response_str = dump_json(response);
+    json_decref(response);
+
+    if (!response_str) {
+        return send_error(connection, HTTP_ERROR_INTERNAL);
+    }
+
+    struct MHD_Response *mhd_response = MHD_create_response_from_buffer(strlen(response_str), response_str, MHD_RESPMEM_MUST_FREE);
+    if (!mhd_response) {
+        free(response_str);
+        return send_error(connection, HTTP_ERROR_INTERNAL);
+    }
+
+    MHD_add_response_header(mhd_response, "Content-Type", "application/json");
+
+    int ret = queue_response(connection, MHD_HTTP_OK, mhd_response);
+    MHD_destroy_response(mhd_response);
+
+    return ret;
+}
+
+int handle_list_sessions(struct MHD_Connection *connection, const struct connection_info *con_info, const RouteParams *params) {
+    (void)con_info;
+    (void)params;
+
+    return send_session_stream(connection, 1);
+}
+
+int handle_debug_sessions(struct MHD_Connection *connection, const struct connection_info *con_info, const RouteParams *params) {
+    (void)con_info;
+    (void)params;
+
+    return send_session_stream(connection, 0);
+}
+
+
+int handle_metrics(struct MHD_Connection *connection, const struct connection_info *con_info, const RouteParams *params) {
+    (void)con_info;
+    (void)params;
+
+    SessionGauges sessions = {0};
+
+    lock_server_state();
+    for (int i = 0; i < server_state.store.session_count; i++) {
+        switch (server_state.store.sessions[i].state) {
+            case WAITING_FOR_PLAYER: sessions.waiting++; break;
+            case IN_PROGRESS: sessions.in_progress++; break;
+            case FINISHED: sessions.finished++; break;
+            default: break;
+        }
+    }
+    unlock_server_state();
+
+    size_t len = 0;
+    char *text = metrics_render(&sessions, &len);
+    if (!text) {
+        return send_error(connection, HTTP_ERROR_INTERNAL);
+    }
+
+    struct MHD_Response *mhd_response = MHD_create_response_from_buffer(len, text, MHD_RESPMEM_MUST_FREE);
+    MHD_add_response_header(mhd_response, "Content-Type", "text/plain; version=0.0.4");
+
+    int ret = queue_response(connection, MHD_HTTP_OK, mhd_response);
+    MHD_destroy_response(mhd_response);
+
+    return ret;
+}
+
+int handle_debug_locks(struct MHD_Connection *connection, const struct connection_info *con_info, const RouteParams *params) {
+    (void)con_info;
+    (void)params;
+
+    char *text = NULL;
+    size_t len = 0;
+
+    FILE *out = open_memstream(&text, &len);
+    if (!out) {
+        return send_error(connection, HTTP_ERROR_INTERNAL);
+    }
+    lock_profile_write(out, LOCK_PROFILE_ROWS);
+    fclose(out);
+
+    struct MHD_Response *mhd_response = MHD_create_response_from_buffer(len, text, MHD_RESPMEM_MUST_FREE);
+    MHD_add_response_header(mhd_response, "Content-Type", "text/plain");
+
+    int ret = queue_response(connection, MHD_HTTP_OK, mhd_response);
+    MHD_destroy_response(mhd_response);
+
+    return ret;
+}
+
+int handle_debug_trace(struct MHD_Connection *connection, const struct connection_info *con_info, const RouteParams *params) {
+    (void)con_info;
+    (void)params;
+
+    char *text = NULL;
+    size_t len = 0;
+
+    FILE *out = open_memstream(&text, &len);
+    if (!out) {
+        return send_error(connection, HTTP_ERROR_INTERNAL);
+    }
+    trace_write(out);
+    fclose(out);
+
+    struct MHD_Response *mhd_response = MHD_create_response_from_buffer(len, text, MHD_RESPMEM_MUST_FREE);
+    MHD_add_response_header(mhd_response, "Content-Type", "application/json");
+
+    int ret = queue_response(connection, MHD_HTTP_OK, mhd_response);
+    MHD_destroy_response(mhd_response);
+
+    return ret;
+}
+
+
+int handle_delete_session(struct MHD_Connection *connection, const struct connection_info *con_info, const RouteParams *params) {
+    (void)con_info;
+
+    char session_id_str[SESSION_ID_STR_LEN];
+    SessionId session_id;
+    if (!route_param_copy(&params->values[0], session_id_str, sizeof(session_id_str)) ||
+        !parse_session_id(session_id_str, &session_id)) {
+        return send_error(connection, HTTP_ERROR_NOT_FOUND);
+    }
+
+    const char *authorization = MHD_lookup_connection_value(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_AUTHORIZATION);
+    PlayerToken token;
+    if (!authorization || strncmp(authorization, "Bearer ", 7) != 0 || !parse_player_token(authorization + 7, &token)) {
+        return send_error(connection, HTTP_ERROR_UNAUTHORIZED);
+    }
+
+    lock_server_state();
+
+    GameSession *session = find_session(&server_state.store, session_id);
+    if (!session) {
+        unlock_server_state();
+        return send_error(connection, HTTP_ERROR_NOT_FOUND);
+    }
+
+    // Either player may end a session once it has two.
+    SessionInfo *info = session_info(&server_state.store, session);
+    if (!player_token_matches(token, info->token1) &&
+        (session->state == WAITING_FOR_PLAYER || !player_token_matches(token, info->token2))) {
+        unlock_server_state();
+        return send_error(connection, HTTP_ERROR_FORBIDDEN);
+    }
+
+    if (session->state == WAITING_FOR_PLAYER) {
+        lobby_session_removed(info->id);
+    }
+    close_session_clients(session);
+    drop_public_state((int)(session - server_state.store.sessions));
+    remove_session(&server_state.store, session);
+
+    unlock_server_state();
+
+    notify_closed_sessions();
+
+    return queue_response(connection, MHD_HTTP_NO_CONTENT, no_content_response);
+}
+
+
+
+static const HttpRouteEntry http_routes[] = {
+    { "POST", "/create", HTTP_ROUTE_CREATE, handle_create_session },
+    { "POST", "/join", HTTP_ROUTE_JOIN, handle_join_session },
+    { "POST", "/quickmatch", HTTP_ROUTE_QUICKMATCH, handle_quickmatch },
+    { "GET", "/sessions", HTTP_ROUTE_SESSIONS, handle_list_sessions },
+    { "GET", "/session/{id}", HTTP_ROUTE_SESSION, handle_get_session },
+    { "DELETE", "/session/{id}", HTTP_ROUTE_SESSION, handle_delete_session },
+    { "GET", "/metrics", HTTP_ROUTE_METRICS, handle_metrics },
+    { "GET", "/debug/locks", HTTP_ROUTE_DEBUG_LOCKS, handle_debug_locks },
+    { "GET", "/debug/trace", HTTP_ROUTE_DEBUG_TRACE, handle_debug_trace },
+    { "GET", "/debug/sessions", HTTP_ROUTE_DEBUG_SESSIONS, handle_debug_sessions },
+    { NULL, NULL, HTTP_ROUTE_OTHER, NULL }
+};
+
+int http_server_init(void) {
+    public_states = calloc((size_t)server_state.store.capacity, sizeof(PublicState *));
+    if (!public_states) {
+        return 0;
+    }
+
+    router_init(&router);
+    for (int i = 0; http_routes[i].method; i++) {
+        if (!router_add(&router, http_routes[i].method, http_routes[i].pattern, i)) {
+            return 0;
+        }
+    }
+
+    no_content_response = MHD_create_response_from_buffer(0, (void *)"", MHD_RESPMEM_PERSISTENT);
+    if (!no_content_response) {
+        return 0;
+    }
+
+    for (int i = 0; i < HTTP_ERROR_COUNT; i++) {
+        const char *body = error_replies[i].body;
+
+        error_responses[i] = MHD_create_response_from_buffer(strlen(body), (void *)body, MHD_RESPMEM_PERSISTENT);
+        if (!error_responses[i]) {
+            http_server_destroy();
+            return 0;
+        }
+        MHD_add_response_header(error_responses[i], "Content-Type", "application/json");
+    }
+
+    return 1;
+}
+
+void http_server_destroy(void) {
+    for (int i = 0; i < HTTP_ERROR_COUNT; i++) {
+        if (error_responses[i]) {
+            MHD_destroy_response(error_responses[i]);
+            error_responses[i] = NULL;
+        }
+    }
+
+    if (no_content_response) {
+        MHD_destroy_response(no_content_response);
+        no_content_response = NULL;
+    }
+
+    if (public_states) {
+        for (int i = 0; i < server_state.store.capacity; i++) {
+            public_state_release(public_states[i]);
+        }
+        free(public_states);
+        public_states = NULL;
+    }
+}
+
+
+
+
+enum MHD_Result http_handler(void *cls, struct MHD_Connection *connection,
+    const char *url, const char *method,
+    const char *version, const char *upload_data,
+    size_t *upload_data_size, void **con_cls) {
+    (void)cls;
+    (void)version;
+
+    if (*con_cls == NULL) {
+        size_t content_length = 0;
+        const char *content_length_str = MHD_lookup_connection_value(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_CONTENT_LENGTH);
+
+        if (content_length_str) {
+            char *end;
+            unsigned long long value = strtoull(content_length_str, &end, 10);
+            if (end != content_length_str && *end == '\0') {
+                content_length = (size_t)value;
+            }
+        }
+
+        // Refused before MHD reads the body or sends 100 Continue.
+        if (content_length > MHD_MAX_JSON_SIZE) {
+            int ret = send_error(connection, HTTP_ERROR_PAYLOAD_TOO_LARGE);
+            metrics_count_http_request(HTTP_ROUTE_OTHER, response_status);
+            return ret;
+        }
+
+        struct connection_info *con_info = connection_info_create(content_length);
+    
+        if (!con_info) return MHD_NO;
+
+        *con_cls = con_info;
+
+        if (*upload_data_size) {
+            if (!connection_info_append(con_info, upload_data, *upload_data_size)) {
+                connection_info_free(con_info);
+                *con_cls = NULL;
+                return MHD_NO;
+            }
+            *upload_data_size = 0;
+        }
+    
+        return MHD_YES;
+    }
+
+    struct connection_info *con_info = *con_cls;
+
+    if (*upload_data_size) {
+        if (!connection_info_append(con_info, upload_data, *upload_data_size)) {
+            connection_info_free(con_info);
+            *con_cls = NULL;
+            return MHD_NO;
+        }
+        *upload_data_size = 0;
+
+        return MHD_YES;
+    }
+
+    enum MHD_Result result = MHD_NO;
+    HttpRoute route = HTTP_ROUTE_OTHER;
+    uint64_t start = metrics_now_ns();
+    response_status = 0;
+
+    // JSON parsed or built by the handlers comes from the request's arena.
+    Arena *previous_arena = arena_enter(&con_info->arena);
+
+    RouteParams params;
+    int entry = 0;
+
+    if (con_info->too_large) {
+        result = send_error(connection, HTTP_ERROR_PAYLOAD_TOO_LARGE);
+    } else {
+        switch (router_match(&router, method, url, &entry, &params)) {
+            case ROUTE_FOUND:
+                route = http_routes[entry].metric;
+                result = http_routes[entry].handler(connection, con_info, &params);
+                break;
+            case ROUTE_METHOD_NOT_ALLOWED:
+                result = send_error(connection, HTTP_ERROR_METHOD_NOT_ALLOWED);
+                break;
+            default:
+                result = send_error(connection, HTTP_ERROR_NOT_FOUND);
+                break;
+        }
+    }
+
+    arena_leave(previous_arena);
+
+    metrics_count_http_request(route, response_status);
+    metrics_observe(METRIC_HTTP_REQUEST_DURATION, metrics_now_ns() - start);
+
+    connection_info_free(con_info);
+    *con_cls = NULL;
+
+    return result;
+}
@@ -0,0 +1,138 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <jansson.h>
+
+#include "lobby.h"
+#include "ws_server.h"
+#include "server.h"
+#include "protocol.h"
+
+static _Atomic(LobbyEvent *) lobby_inbox;
+// Guarded by server_state.mutex.
+static uint64_t lobby_seq;
+
+// Owned by the lws thread.
+static LobbySubscriber *subscribers;
+static int subscriber_count;
+static int subscriber_cap;
+
+
+
+static void publish(json_t *event) {
+    char *text = dump_json(event);
+    json_decref(event);
+    if (!text) return;
+
+    size_t len = strlen(text);
+    LobbyEvent *entry = malloc(sizeof(LobbyEvent) + len + 1);
+    if (entry) {
+        entry->seq = ++lobby_seq;
+        memcpy(entry->text, text, len + 1);
+
+        LobbyEvent *head = atomic_load(&lobby_inbox);
+        do {
+            entry->next = head;
+        } while (!atomic_compare_exchange_weak(&lobby_inbox, &head, entry));
+
+        if (ws_context) lws_cancel_service(ws_context);
+    }
+
+    free(text);
+}
+
+void lobby_session_added(const GameSession *session, const SessionInfo *info) {
+    json_t *event = json_object();
+    json_object_set_new(event, "type", json_string("lobby_added"));
+    json_object_set_new(event, "session", serialize_lobby_session(session, info));
+    publish(event);
+}
+
+void lobby_session_removed(SessionId id) {
+    char session_id_str[SESSION_ID_STR_LEN];
+    format_session_id(id, session_id_str);
+
+    json_t *event = json_object();
+    json_object_set_new(event, "type", json_string("lobby_removed"));
+    json_object_set_new(event, "id", json_string(session_id_str));
+    publish(event);
+}
+
+/* Adds wsi and sends it the waiting sessions as they are now. */
+void lobby_subscribe(struct lws *wsi) {
+    for (int i = 0; i < subscriber_count; i++) {
+        if (subscribers[i].wsi == wsi) return;
+    }
+
+    if (subscriber_count == subscriber_cap) {
+        int cap = subscriber_cap ? subscriber_cap * 2 : 16;
+        LobbySubscriber *grown = realloc(subscribers, sizeof(LobbySubscriber) * (size_t)cap);
+        if (!grown) return;
+
+        subscribers = grown;
+        subscriber_cap = cap;
+    }
+
+    json_t *sessions = json_array();
+
+    lock_server_state();
+    for (int i = 0; i < server_state.store.session_count; i++) {
+        GameSession *session = &server_state.store.sessions[i];
+        if (session->state == WAITING_FOR_PLAYER) {
+            json_array_append_new(sessions, serialize_lobby_session(session, &server_state.store.infos[i]));
+        }
+    }
+    subscribers[subscriber_count++] = (LobbySubscriber){ wsi, lobby_seq };
+    unlock_server_state();
+
+    json_t *snapshot = json_object();
+    json_object_set_new(snapshot, "type", json_string("lobby_snapshot"));
+    json_object_set_new(snapshot, "sessions", sessions);
+
+    char *text = dump_json(snapshot);
+    json_decref(snapshot);
+
+    if (text) {
+        send_ws_message(wsi, text);
+        free(text);
+    }
+}
+
+void lobby_unsubscribe(struct lws *wsi) {
+    for (int i = 0; i < subscriber_count; i++) {
+        if (subscribers[i].wsi == wsi) {
+            subscribers[i] = subscribers[--subscriber_count];
+            return;
+        }
+    }
+}
+
+void lobby_flush(void) {
+    LobbyEvent *stack = atomic_exchange(&lobby_inbox, NULL);
+
+    // The inbox is LIFO; reverse it so events go out in publication order.
+    LobbyEvent *events = NULL;
+    while (stack) {
+        LobbyEvent *next = stack->next;
+        stack->next = events;
+        events = stack;
+        stack = next;
+    }
+
+    while (events) {
+        LobbyEvent *next = events->next;
+
+        WsPayload *payload = ws_payload_create(events->text);
+        if (payload) {
+            for (int i = 0; i < subscriber_count; i++) {
+                if (events->seq > subscribers[i].seen_seq) {
+                    send_ws_payload(subscribers[i].wsi, payload);
+                }
+            }
+            ws_payload_release(payload);
+        }
+
+        free(events);
+        events = next;
+    }
+}
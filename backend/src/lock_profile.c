@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "lock_profile.h"
+
+#ifdef LOCK_PROFILING
+
+typedef struct {
+    const LockSite *site;
+    uint64_t acquisitions;
+    uint64_t contended;
+    uint64_t wait_ns;
+    uint64_t max_wait_ns;
+    uint64_t hold_ns;
+    uint64_t max_hold_ns;
+} LockSiteSnapshot;
+
+// Sites register on first use and are never removed.
+static _Atomic(LockSite *) lock_sites;
+
+
+
+static void register_site(LockSite *site) {
+    if (atomic_load_explicit(&site->registered, memory_order_acquire) ||
+        atomic_exchange(&site->registered, 1)) {
+        return;
+    }
+
+    LockSite *head = atomic_load(&lock_sites);
+    do {
+        site->next = head;
+    } while (!atomic_compare_exchange_weak(&lock_sites, &head, site));
+}
+
+static void record_max(_Atomic uint64_t *cell, uint64_t value) {
+    uint64_t current = atomic_load_explicit(cell, memory_order_relaxed);
+    while (value > current &&
+        !atomic_compare_exchange_weak_explicit(cell, &current, value, memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+int prof_mutex_init(ProfMutex *m) {
+    m->holder = NULL;
+    m->acquired_ns = 0;
+    return pthread_mutex_init(&m->mutex, NULL) == 0;
+}
+
+void prof_mutex_destroy(ProfMutex *m) {
+    pthread_mutex_destroy(&m->mutex);
+}
+
+uint64_t prof_mutex_lock(ProfMutex *m, LockSite *site) {
+    register_site(site);
+
+    uint64_t wait_ns = 0;
+    if (pthread_mutex_trylock(&m->mutex) != 0) {
+        uint64_t start = lock_profile_now_ns();
+        pthread_mutex_lock(&m->mutex);
+        wait_ns = lock_profile_now_ns() - start;
+        if (!wait_ns) wait_ns = 1;
+
+        atomic_fetch_add_explicit(&site->contended, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&site->wait_ns, wait_ns, memory_order_relaxed);
+        record_max(&site->max_wait_ns, wait_ns);
+    }
+
+    atomic_fetch_add_explicit(&site->acquisitions, 1, memory_order_relaxed);
+    m->holder = site;
+    m->acquired_ns = lock_profile_now_ns();
+
+    return wait_ns;
+}
+
+void prof_mutex_unlock(ProfMutex *m) {
+    LockSite *site = m->holder;
+    uint64_t hold_ns = lock_profile_now_ns() - m->acquired_ns;
+    m->holder = NULL;
+
+    pthread_mutex_unlock(&m->mutex);
+
+    atomic_fetch_add_explicit(&site->hold_ns, hold_ns, memory_order_relaxed);
+    record_max(&site->max_hold_ns, hold_ns);
+}
+
+
+
+static int compare_by_wait(const void *a, const void *b) {
+    const LockSiteSnapshot *sa = a;
+    const LockSiteSnapshot *sb = b;
+
+    if (sa->wait_ns != sb->wait_ns) return sa->wait_ns < sb->wait_ns ? 1 : -1;
+    if (sa->hold_ns != sb->hold_ns) return sa->hold_ns < sb->hold_ns ? 1 : -1;
+    return 0;
+}
+
+void lock_profile_write(FILE *out, int limit) {
+    int count = 0;
+    for (const LockSite *site = atomic_load(&lock_sites); site; site = site->next) {
+        count++;
+    }
+
+    LockSiteSnapshot *rows = calloc(count ? (size_t)count : 1, sizeof(LockSiteSnapshot));
+    if (!rows) return;
+
+    // Sites registered after the count are further up the list and skipped.
+    const LockSite *site = atomic_load(&lock_sites);
+    for (int i = 0; i < count && site; i++, site = site->next) {
+        rows[i] = (LockSiteSnapshot) {
+            .site = site,
+            .acquisitions = atomic_load_explicit(&site->acquisitions, memory_order_relaxed),
+            .contended = atomic_load_explicit(&site->contended, memory_order_relaxed),
+            .wait_ns = atomic_load_explicit(&site->wait_ns, memory_order_relaxed),
+            .max_wait_ns = atomic_load_explicit(&site->max_wait_ns, memory_order_relaxed),
+            .hold_ns = atomic_load_explicit(&site->hold_ns, memory_order_relaxed),
+            .max_hold_ns = atomic_load_explicit(&site->max_hold_ns, memory_order_relaxed),
+        };
+    }
+
+    qsort(rows, (size_t)count, sizeof(LockSiteSnapshot), compare_by_wait);
+
+    fprintf(out, "%-44s %10s %10s %12s %10s %10s %12s %10s %10s\n",
+        "site", "acquired", "contended", "wait_total", "wait_avg", "wait_max", "hold_total", "hold_avg", "hold_max");
+
+    for (int i = 0; i < count && i < limit; i++) {
+        const LockSiteSnapshot *row = &rows[i];
+        char where[128];
+        snprintf(where, sizeof(where), "%s:%d %s", row->site->file, row->site->line, row->site->function);
+
+        uint64_t acquisitions = row->acquisitions ? row->acquisitions : 1;
+        uint64_t contended = row->contended ? row->contended : 1;
+
+        // Times in microseconds; wait_avg is over the contended acquisitions only.
+        fprintf(out, "%-44s %10llu %10llu %12.1f %10.2f %10.1f %12.1f %10.2f %10.1f\n",
+            where,
+            (unsigned long long)row->acquisitions,
+            (unsigned long long)row->contended,
+            row->wait_ns / 1e3, row->wait_ns / 1e3 / contended, row->max_wait_ns / 1e3,
+            row->hold_ns / 1e3, row->hold_ns / 1e3 / acquisitions, row->max_hold_ns / 1e3);
+    }
+
+    free(rows);
+}
+
+#else
+
+void lock_profile_write(FILE *out, int limit) {
+    (void)limit;
+    fprintf(out, "lock profiling is disabled; rebuild with make LOCK_PROFILING=1\n");
+}
+
+#endif // LOCK_PROFILING
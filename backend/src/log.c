@@ -0,0 +1,211 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "log.h"
+
+#define LOG_IDLE_SLEEP_NS 10000000
+
+atomic_int log_min_level = LOG_INFO;
+
+static _Thread_local LogRing *log_thread_ring;
+
+static LogRing *rings;
+static int ring_count;
+static pthread_mutex_t rings_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t ring_key;
+static pthread_once_t ring_key_once = PTHREAD_ONCE_INIT;
+
+static _Atomic uint64_t dropped;
+static atomic_int running;
+static pthread_t writer;
+
+static const char *level_names[] = { "debug", "info", "warn", "error" };
+
+
+
+static void release_ring(void *arg) {
+    LogRing *ring = arg;
+    atomic_store(&ring->in_use, 0);
+}
+
+static void create_ring_key(void) {
+    pthread_key_create(&ring_key, release_ring);
+}
+
+// Rings outlive their threads and are reused; the writer drains them either way.
+static LogRing* attach_thread(void) {
+    pthread_once(&ring_key_once, create_ring_key);
+    pthread_mutex_lock(&rings_mutex);
+
+    LogRing *ring = rings;
+    while (ring && atomic_load(&ring->in_use)) {
+        ring = ring->next;
+    }
+
+    if (!ring) {
+        ring = calloc(1, sizeof(LogRing));
+        if (!ring) {
+            pthread_mutex_unlock(&rings_mutex);
+            return NULL;
+        }
+        ring->thread_slot = ++ring_count;
+        ring->next = rings;
+        rings = ring;
+    }
+
+    atomic_store(&ring->in_use, 1);
+    pthread_mutex_unlock(&rings_mutex);
+
+    pthread_setspecific(ring_key, ring);
+    log_thread_ring = ring;
+    return ring;
+}
+
+int64_t log_rate_check(LogRateLimit *limit) {
+    int64_t now = (int64_t)time(NULL);
+    int64_t window = atomic_load_explicit(&limit->window, memory_order_relaxed);
+
+    if (window != now && atomic_compare_exchange_strong(&limit->window, &window, now)) {
+        atomic_store_explicit(&limit->count, 0, memory_order_relaxed);
+    }
+
+    if (atomic_fetch_add_explicit(&limit->count, 1, memory_order_relaxed) >= limit->per_second) {
+        atomic_fetch_add_explicit(&limit->suppressed, 1, memory_order_relaxed);
+        return -1;
+    }
+
+    return (int64_t)atomic_exchange_explicit(&limit->suppressed, 0, memory_order_relaxed);
+}
+
+void log_write(LogLevel level, uint64_t suppressed, const char *message, const char *fields, ...) {
+    LogRing *ring = log_thread_ring ? log_thread_ring : attach_thread();
+    if (!ring) {
+        atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if (head - atomic_load_explicit(&ring->tail, memory_order_acquire) >= LOG_RING_RECORDS) {
+        atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    LogRecord *record = &ring->records[head % LOG_RING_RECORDS];
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    record->time_ns = (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+    record->level = (uint8_t)level;
+
+    int len = snprintf(record->text, sizeof(record->text), "msg=%s ", message);
+
+    if (len < (int)sizeof(record->text)) {
+        va_list args;
+        va_start(args, fields);
+        len += vsnprintf(record->text + len, sizeof(record->text) - (size_t)len, fields, args);
+        va_end(args);
+    }
+
+    if (suppressed && len < (int)sizeof(record->text)) {
+        len += snprintf(record->text + len, sizeof(record->text) - (size_t)len,
+            " suppressed=%llu", (unsigned long long)suppressed);
+    }
+
+    record->len = (uint16_t)(len < (int)sizeof(record->text) ? len : (int)sizeof(record->text) - 1);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+
+
+int log_parse_level(const char *name, LogLevel *level) {
+    for (int i = LOG_DEBUG; i <= LOG_ERROR; i++) {
+        if (strcmp(name, level_names[i]) == 0) {
+            *level = (LogLevel)i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void log_set_level(LogLevel level) {
+    atomic_store(&log_min_level, (int)level);
+}
+
+static void write_record(const LogRecord *record, int thread_slot) {
+    time_t seconds = (time_t)(record->time_ns / 1000000000);
+    struct tm tm;
+    gmtime_r(&seconds, &tm);
+
+    char stamp[32];
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", &tm);
+
+    printf("ts=%s.%06uZ level=%s thread=%d %.*s\n",
+        stamp, (unsigned)(record->time_ns % 1000000000 / 1000), level_names[record->level],
+        thread_slot, (int)record->len, record->text);
+}
+
+static int drain(void) {
+    pthread_mutex_lock(&rings_mutex);
+    LogRing *head = rings;
+    pthread_mutex_unlock(&rings_mutex);
+
+    int written = 0;
+
+    for (LogRing *ring = head; ring; ring = ring->next) {
+        uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint64_t end = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+        for (; tail < end; tail++) {
+            write_record(&ring->records[tail % LOG_RING_RECORDS], ring->thread_slot);
+            written++;
+        }
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+
+    uint64_t lost = atomic_exchange_explicit(&dropped, 0, memory_order_relaxed);
+    if (lost) {
+        LogRecord notice = { .level = LOG_WARN };
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        notice.time_ns = (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+        notice.len = (uint16_t)snprintf(notice.text, sizeof(notice.text), "msg=log_dropped count=%llu", (unsigned long long)lost);
+
+        write_record(&notice, 0);
+        written++;
+    }
+
+    if (written) fflush(stdout);
+    return written;
+}
+
+static void* writer_main(void *arg) {
+    (void)arg;
+
+    while (atomic_load(&running)) {
+        if (!drain()) {
+            struct timespec idle = { 0, LOG_IDLE_SLEEP_NS };
+            nanosleep(&idle, NULL);
+        }
+    }
+
+    drain();
+    return NULL;
+}
+
+int log_start(void) {
+    atomic_store(&running, 1);
+    if (pthread_create(&writer, NULL, writer_main, NULL) != 0) {
+        atomic_store(&running, 0);
+        return 0;
+    }
+    return 1;
+}
+
+void log_stop(void) {
+    if (!atomic_exchange(&running, 0)) return;
+    pthread_join(writer, NULL);
+}
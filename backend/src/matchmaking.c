@@ -0,0 +1,236 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <jansson.h>
+
+#include "matchmaking.h"
+#include "ws_server.h"
+#include "server.h"
+#include "protocol.h"
+#include "log.h"
+
+// Tickets from POST /quickmatch, pushed by HTTP threads.
+static _Atomic(MatchRequest *) ticket_inbox;
+// Tickets in the inbox or unclaimed_tickets.
+static atomic_int outstanding_tickets;
+
+// Owned by the lws thread: tickets not yet claimed, and the player waiting
+// per variant. Two waiting players are paired at once, so one slot is enough.
+static MatchRequest *unclaimed_tickets;
+static MatchRequest *waiting[VARIANT_COUNT];
+
+
+
+QuickmatchResult quickmatch_register(const char *player_name, int variant, PlayerToken *ticket) {
+    if (atomic_fetch_add(&outstanding_tickets, 1) >= QUICKMATCH_MAX_TICKETS) {
+        atomic_fetch_sub(&outstanding_tickets, 1);
+        return QUICKMATCH_FULL;
+    }
+
+    MatchRequest *request = calloc(1, sizeof(MatchRequest));
+    if (!request || !generate_player_token(&request->ticket)) {
+        free(request);
+        atomic_fetch_sub(&outstanding_tickets, 1);
+        return QUICKMATCH_ERROR;
+    }
+
+    strncpy(request->player_name, player_name, sizeof(request->player_name) - 1);
+    request->variant = variant;
+    request->expires_at = time(NULL) + QUICKMATCH_TICKET_TTL;
+    *ticket = request->ticket;
+
+    MatchRequest *head = atomic_load(&ticket_inbox);
+    do {
+        request->next = head;
+    } while (!atomic_compare_exchange_weak(&ticket_inbox, &head, request));
+
+    return QUICKMATCH_REGISTERED;
+}
+
+static void send_matched(struct lws *wsi, const SessionInfo *info, int player_num, int variant) {
+    char session_id_str[SESSION_ID_STR_LEN];
+    format_session_id(info->id, session_id_str);
+
+    char token_str[PLAYER_TOKEN_STR_LEN];
+    format_player_token(player_num == 1 ? info->token1 : info->token2, token_str);
+
+    json_t *message = json_object();
+    json_object_set_new(message, "type", json_string("matched"));
+    json_object_set_new(message, "session_id", json_string(session_id_str));
+    json_object_set_new(message, "token", json_string(token_str));
+    json_object_set_new(message, "player", json_string(player_num == 1 ? "Player 1" : "Player 2"));
+    json_object_set_new(message, "opponent", json_string(player_num == 1 ? info->player2 : info->player1));
+    json_object_set_new(message, "variant", json_string(game_variants[variant].name));
+
+    char *message_str = dump_json(message);
+    json_decref(message);
+
+    if (message_str) {
+        send_ws_message(wsi, message_str);
+        free(message_str);
+    }
+}
+
+/*
+    Creates the session for two waiting players and binds both sockets to
+    it. If only one socket could be bound, the session is removed and that
+    player's request is returned to be queued again; otherwise NULL.
+*/
+static MatchRequest* start_match(MatchRequest *first, MatchRequest *second) {
+    MatchRequest *requeue = NULL;
+
+    lock_server_state();
+
+    GameSession *session = create_session(&server_state.store, first->player_name, first->variant);
+    if (session && !join_session(&server_state.store, session, second->player_name)) {
+        remove_session(&server_state.store, session);
+        session = NULL;
+    }
+
+    if (session) {
+        SessionInfo *info = session_info(&server_state.store, session);
+        int first_bound = bind_ws_client(first->wsi, session, 1);
+        int second_bound = bind_ws_client(second->wsi, session, 2);
+
+        if (first_bound && second_bound) {
+            send_matched(first->wsi, info, 1, first->variant);
+            send_game_state(session, 1);
+            send_matched(second->wsi, info, 2, first->variant);
+            send_game_state(session, 2);
+        } else {
+            // A socket out of seats fails alone; its opponent never saw the session.
+            if (first_bound) {
+                unbind_ws_seat(first->wsi, session, 1);
+                requeue = first;
+            } else {
+                send_ws_message(first->wsi, "{\"type\":\"quickmatch_failed\"}");
+            }
+            if (second_bound) {
+                unbind_ws_seat(second->wsi, session, 2);
+                requeue = second;
+            } else {
+                send_ws_message(second->wsi, "{\"type\":\"quickmatch_failed\"}");
+            }
+
+            LOG(LOG_WARN, "quickmatch_bind_failed", "variant=%s", game_variants[first->variant].name);
+            remove_session(&server_state.store, session);
+        }
+    }
+
+    unlock_server_state();
+
+    if (!session) {
+        LOG(LOG_WARN, "quickmatch_failed", "variant=%s", game_variants[first->variant].name);
+        send_ws_message(first->wsi, "{\"type\":\"quickmatch_failed\"}");
+        send_ws_message(second->wsi, "{\"type\":\"quickmatch_failed\"}");
+    }
+
+    return requeue;
+}
+
+static int is_waiting(struct lws *wsi) {
+    for (int v = 0; v < VARIANT_COUNT; v++) {
+        if (waiting[v] && waiting[v]->wsi == wsi) return 1;
+    }
+    return 0;
+}
+
+// Takes ownership of request.
+static void enqueue_waiting(MatchRequest *request) {
+    MatchRequest *opponent = waiting[request->variant];
+
+    if (!opponent) {
+        request->next = NULL;
+        waiting[request->variant] = request;
+        send_ws_message(request->wsi, "{\"type\":\"quickmatch_waiting\"}");
+        return;
+    }
+
+    waiting[request->variant] = NULL;
+    MatchRequest *requeue = start_match(opponent, request);
+
+    if (opponent != requeue) free(opponent);
+    if (request != requeue) free(request);
+    if (requeue) enqueue_waiting(requeue);
+}
+
+int quickmatch_join(struct lws *wsi, const char *player_name, int variant) {
+    if (is_waiting(wsi)) return 0;
+
+    MatchRequest *request = calloc(1, sizeof(MatchRequest));
+    if (!request) return 0;
+
+    strncpy(request->player_name, player_name, sizeof(request->player_name) - 1);
+    request->variant = variant;
+    request->wsi = wsi;
+
+    enqueue_waiting(request);
+    return 1;
+}
+
+/*
+    Moves the inbox onto unclaimed_tickets, freeing expired tickets on the
+    way. Unlinks and returns the ticket matching claim, if any is still
+    valid; pass NULL to only expire.
+*/
+static MatchRequest* sweep_tickets(const PlayerToken *claim) {
+    MatchRequest *inbox = atomic_exchange(&ticket_inbox, NULL);
+    while (inbox) {
+        MatchRequest *next = inbox->next;
+        inbox->next = unclaimed_tickets;
+        unclaimed_tickets = inbox;
+        inbox = next;
+    }
+
+    time_t now = time(NULL);
+    MatchRequest *claimed = NULL;
+    MatchRequest **link = &unclaimed_tickets;
+
+    while (*link) {
+        MatchRequest *request = *link;
+
+        if (request->expires_at < now) {
+            *link = request->next;
+            free(request);
+            atomic_fetch_sub(&outstanding_tickets, 1);
+        } else if (!claimed && claim && player_token_matches(request->ticket, *claim)) {
+            *link = request->next;
+            claimed = request;
+            atomic_fetch_sub(&outstanding_tickets, 1);
+        } else {
+            link = &request->next;
+        }
+    }
+
+    return claimed;
+}
+
+int quickmatch_claim(struct lws *wsi, PlayerToken ticket) {
+    if (is_waiting(wsi)) return 0;
+
+    MatchRequest *claimed = sweep_tickets(&ticket);
+    if (!claimed) return 0;
+
+    claimed->wsi = wsi;
+    enqueue_waiting(claimed);
+    return 1;
+}
+
+void quickmatch_expire_tickets(void) {
+    static time_t last_sweep;
+    time_t now = time(NULL);
+
+    if (now == last_sweep) return;
+    last_sweep = now;
+
+    sweep_tickets(NULL);
+}
+
+void quickmatch_cancel(struct lws *wsi) {
+    for (int v = 0; v < VARIANT_COUNT; v++) {
+        if (waiting[v] && waiting[v]->wsi == wsi) {
+            free(waiting[v]);
+            waiting[v] = NULL;
+        }
+    }
+}
@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "metrics.h"
+
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} TextBuffer;
+
+_Thread_local MetricsShard *metrics_thread_shard;
+
+static MetricsShard *shards;
+static pthread_mutex_t shards_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t shard_key;
+static pthread_once_t shard_key_once = PTHREAD_ONCE_INIT;
+
+static const char *counter_names[METRIC_COUNTER_COUNT][3] = {
+    // name, type, help
+    [METRIC_MOVES] = { "battleship_moves_total", "counter", "Attacks applied, including bot moves." },
+    [METRIC_BOT_MOVES] = { "battleship_bot_moves_total", "counter", "Attacks applied by a bot." },
+    [METRIC_SERIALIZED_BYTES] = { "battleship_serialized_bytes_total", "counter", "Bytes of JSON produced for clients." },
+    [METRIC_WS_CONNECTIONS] = { "battleship_ws_connections", "gauge", "Open WebSocket connections." },
+    [METRIC_WS_SEND_QUEUE_DEPTH] = { "battleship_ws_send_queue_depth", "gauge", "Frames waiting to be written, all connections." },
+    [METRIC_SPECTATORS] = { "battleship_spectators", "gauge", "WebSocket connections watching a session." },
+    [METRIC_SPECTATOR_FRAMES_DROPPED] = { "battleship_spectator_frames_dropped_total", "counter", "State frames dropped from slow spectators' queues." },
+    [METRIC_LOCK_ACQUISITIONS] = { "battleship_lock_acquisitions_total", "counter", "Acquisitions of the server state lock." },
+    [METRIC_LOCK_CONTENDED] = { "battleship_lock_contended_total", "counter", "Acquisitions of the server state lock that had to wait." },
+};
+
+static const char *histogram_names[METRIC_HISTOGRAM_COUNT][2] = {
+    [METRIC_MOVE_DURATION] = { "battleship_move_duration_seconds", "Time from an attack frame to its replies being queued." },
+    [METRIC_HTTP_REQUEST_DURATION] = { "battleship_http_request_duration_seconds", "Time spent handling a complete HTTP request." },
+    [METRIC_LOCK_WAIT] = { "battleship_lock_wait_seconds", "Time spent waiting for the server state lock." },
+};
+
+static const char *route_names[HTTP_ROUTE_COUNT] = {
+    "/create", "/join", "/quickmatch", "/sessions", "/session/{id}", "/metrics", "/debug/locks", "/debug/trace", "/debug/sessions", "other"
+};
+
+static const char *status_names[HTTP_STATUS_COUNT] = {
+    "200", "204", "304", "400", "401", "403", "404", "405", "413", "500", "503", "other"
+};
+
+// Prometheus bucket bounds, in nanoseconds.
+static const uint64_t le_bounds_ns[] = {
+    1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000,
+    1000000, 2500000, 5000000, 10000000, 25000000, 50000000,
+    100000000, 250000000, 500000000, 1000000000, 2500000000, 5000000000, 10000000000
+};
+
+
+
+static void release_shard(void *arg) {
+    MetricsShard *shard = arg;
+    atomic_store(&shard->in_use, 0);
+}
+
+static void create_shard_key(void) {
+    pthread_key_create(&shard_key, release_shard);
+}
+
+MetricsShard* metrics_attach_thread(void) {
+    pthread_once(&shard_key_once, create_shard_key);
+    pthread_mutex_lock(&shards_mutex);
+
+    MetricsShard *shard = shards;
+    while (shard && atomic_load(&shard->in_use)) {
+        shard = shard->next;
+    }
+
+    if (!shard) {
+        shard = aligned_alloc(64, (sizeof(MetricsShard) + 63) & ~(size_t)63);
+        if (!shard) {
+            pthread_mutex_unlock(&shards_mutex);
+            abort();
+        }
+        memset(shard, 0, sizeof(MetricsShard));
+        shard->next = shards;
+        shards = shard;
+    }
+
+    atomic_store(&shard->in_use, 1);
+    pthread_mutex_unlock(&shards_mutex);
+
+    pthread_setspecific(shard_key, shard);
+    metrics_thread_shard = shard;
+    return shard;
+}
+
+void metrics_count_http_request(HttpRoute route, int status_code) {
+    HttpStatusClass status;
+
+    switch (status_code) {
+        case 200: status = HTTP_STATUS_200; break;
+        case 204: status = HTTP_STATUS_204; break;
+        case 304: status = HTTP_STATUS_304; break;
+        case 400: status = HTTP_STATUS_400; break;
+        case 401: status = HTTP_STATUS_401; break;
+        case 403: status = HTTP_STATUS_403; break;
+        case 404: status = HTTP_STATUS_404; break;
+        case 405: status = HTTP_STATUS_405; break;
+        case 413: status = HTTP_STATUS_413; break;
+        case 500: status = HTTP_STATUS_500; break;
+        case 503: status = HTTP_STATUS_503; break;
+        default: status = HTTP_STATUS_OTHER; break;
+    }
+
+    metrics_bump(&metrics_shard()->http_requests[route][status], 1);
+}
+
+
+
+static void text_append(TextBuffer *buffer, const char *format, ...) {
+    if (!buffer->data) return;
+
+    for (;;) {
+        va_list args;
+        va_start(args, format);
+        int written = vsnprintf(buffer->data + buffer->len, buffer->cap - buffer->len, format, args);
+        va_end(args);
+
+        if (written < 0) return;
+        if ((size_t)written < buffer->cap - buffer->len) {
+            buffer->len += (size_t)written;
+            return;
+        }
+
+        char *data = realloc(buffer->data, buffer->cap * 2 + (size_t)written);
+        if (!data) {
+            free(buffer->data);
+            buffer->data = NULL;
+            return;
+        }
+        buffer->data = data;
+        buffer->cap = buffer->cap * 2 + (size_t)written;
+    }
+}
+
+static void render_histogram(TextBuffer *buffer, const MetricsShard *head, MetricHistogram histogram) {
+    uint64_t buckets[HISTOGRAM_BUCKETS] = {0};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+
+    for (const MetricsShard *shard = head; shard; shard = shard->next) {
+        const MetricsHistogram *h = &shard->histograms[histogram];
+        for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+            buckets[i] += atomic_load_explicit(&h->buckets[i], memory_order_relaxed);
+        }
+        count += atomic_load_explicit(&h->count, memory_order_relaxed);
+        sum += atomic_load_explicit(&h->sum, memory_order_relaxed);
+    }
+
+    const char *name = histogram_names[histogram][0];
+    text_append(buffer, "# HELP %s %s\n# TYPE %s histogram\n", name, histogram_names[histogram][1], name);
+
+    uint64_t cumulative = 0;
+    int bucket = 0;
+    for (size_t i = 0; i < sizeof(le_bounds_ns) / sizeof(le_bounds_ns[0]); i++) {
+        while (bucket < HISTOGRAM_BUCKETS && histogram_bucket_lower_bound(bucket) <= le_bounds_ns[i]) {
+            cumulative += buckets[bucket++];
+        }
+        text_append(buffer, "%s_bucket{le=\"%g\"} %llu\n", name, le_bounds_ns[i] / 1e9, (unsigned long long)cumulative);
+    }
+
+    text_append(buffer, "%s_bucket{le=\"+Inf\"} %llu\n", name, (unsigned long long)count);
+    text_append(buffer, "%s_sum %.9f\n", name, sum / 1e9);
+    text_append(buffer, "%s_count %llu\n", name, (unsigned long long)count);
+}
+
+char* metrics_render(const SessionGauges *sessions, size_t *len) {
+    TextBuffer buffer = { malloc(8192), 0, 8192 };
+
+    // Shards are never freed and are only pushed at the head, so the list
+    // behind a snapshot of the head can be walked without the lock.
+    pthread_mutex_lock(&shards_mutex);
+    const MetricsShard *head = shards;
+    pthread_mutex_unlock(&shards_mutex);
+
+    for (int c = 0; c < METRIC_COUNTER_COUNT; c++) {
+        int64_t total = 0;
+        for (const MetricsShard *shard = head; shard; shard = shard->next) {
+            total += atomic_load_explicit(&shard->counters[c], memory_order_relaxed);
+        }
+
+        text_append(&buffer, "# HELP %s %s\n# TYPE %s %s\n%s %lld\n",
+            counter_names[c][0], counter_names[c][2], counter_names[c][0], counter_names[c][1],
+            counter_names[c][0], (long long)total);
+    }
+
+    text_append(&buffer, "# HELP battleship_sessions Sessions in the store, by state.\n# TYPE battleship_sessions gauge\n");
+    text_append(&buffer, "battleship_sessions{state=\"waiting\"} %lld\n", (long long)sessions->waiting);
+    text_append(&buffer, "battleship_sessions{state=\"in_progress\"} %lld\n", (long long)sessions->in_progress);
+    text_append(&buffer, "battleship_sessions{state=\"finished\"} %lld\n", (long long)sessions->finished);
+
+    text_append(&buffer, "# HELP battleship_http_requests_total HTTP requests by route and status.\n");
+    text_append(&buffer, "# TYPE battleship_http_requests_total counter\n");
+    for (int r = 0; r < HTTP_ROUTE_COUNT; r++) {
+        for (int s = 0; s < HTTP_STATUS_COUNT; s++) {
+            uint64_t total = 0;
+            for (const MetricsShard *shard = head; shard; shard = shard->next) {
+                total += atomic_load_explicit(&shard->http_requests[r][s], memory_order_relaxed);
+            }
+            if (total) {
+                text_append(&buffer, "battleship_http_requests_total{route=\"%s\",status=\"%s\"} %llu\n",
+                    route_names[r], status_names[s], (unsigned long long)total);
+            }
+        }
+    }
+
+    for (int h = 0; h < METRIC_HISTOGRAM_COUNT; h++) {
+        render_histogram(&buffer, head, h);
+    }
+
+    if (buffer.data) *len = buffer.len;
+    return buffer.data;
+}
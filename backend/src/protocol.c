@@ -0,0 +1,183 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "protocol.h"
+#include "metrics.h"
+
+// Enough for a classic game_state message without regrowing.
+#define JSON_TEXT_INITIAL 4096
+
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} JsonText;
+
+
+
+json_t* serialize_board(const Board *board) {
+    json_t* board_json = json_object();
+    json_t* cells = json_array();
+    json_t* ships = json_array();
+    
+    for (int y = 0; y < board->size; y++) {
+        json_t* row = json_array();
+        for (int x = 0; x < board->size; x++) {
+            json_array_append_new(row, json_integer(board_cell(board, x, y)));
+        }
+        json_array_append_new(cells, row);
+    }
+    json_object_set_new(board_json, "cells", cells);
+    
+    for (int i = 0; i < board->ship_count; i++) {
+        json_t* ship_json = json_object();
+        json_object_set_new(ship_json, "size", json_integer(board->ships[i].size));
+        json_object_set_new(ship_json, "hits", json_integer(ship_hits(board, &board->ships[i])));
+        
+        const Ship *ship = &board->ships[i];
+        json_t* points = json_array();
+        for (int j = 0; j < ship->size; j++) {
+            json_t* point = json_object();
+            json_object_set_new(point, "x", json_integer(ship->x + (ship->is_horizontal ? j : 0)));
+            json_object_set_new(point, "y", json_integer(ship->y + (ship->is_horizontal ? 0 : j)));
+            json_array_append_new(points, point);
+        }
+        json_object_set_new(ship_json, "points", points);
+        json_array_append_new(ships, ship_json);
+    }
+    json_object_set_new(board_json, "ships", ships);
+    
+    return board_json;
+}
+
+// Board as the opponent sees it: intact ship cells read as EMPTY and only sunk ships are listed.
+static json_t* serialize_public_board(const Board *board) {
+    json_t* board_json = json_object();
+    json_t* cells = json_array();
+    json_t* ships = json_array();
+
+    for (int y = 0; y < board->size; y++) {
+        json_t* row = json_array();
+        for (int x = 0; x < board->size; x++) {
+            CellState cell = board_cell(board, x, y);
+            json_array_append_new(row, json_integer(cell == SHIP ? EMPTY : cell));
+        }
+        json_array_append_new(cells, row);
+    }
+    json_object_set_new(board_json, "cells", cells);
+
+    for (int i = 0; i < board->ship_count; i++) {
+        const Ship *ship = &board->ships[i];
+        if (ship_hits(board, ship) < ship->size) continue;
+
+        json_t* ship_json = json_object();
+        json_object_set_new(ship_json, "size", json_integer(ship->size));
+        json_object_set_new(ship_json, "hits", json_integer(ship->size));
+
+        json_t* points = json_array();
+        for (int j = 0; j < ship->size; j++) {
+            json_t* point = json_object();
+            json_object_set_new(point, "x", json_integer(ship->x + (ship->is_horizontal ? j : 0)));
+            json_object_set_new(point, "y", json_integer(ship->y + (ship->is_horizontal ? 0 : j)));
+            json_array_append_new(points, point);
+        }
+        json_object_set_new(ship_json, "points", points);
+        json_array_append_new(ships, ship_json);
+    }
+    json_object_set_new(board_json, "ships", ships);
+
+    return board_json;
+}
+
+json_t* serialize_lobby_session(const GameSession *session, const SessionInfo *info) {
+    char session_id_str[SESSION_ID_STR_LEN];
+    format_session_id(info->id, session_id_str);
+
+    json_t *session_obj = json_object();
+    json_object_set_new(session_obj, "id", json_string(session_id_str));
+    json_object_set_new(session_obj, "player1", json_string(info->player1));
+    json_object_set_new(session_obj, "created_at", json_integer(info->created_at));
+    json_object_set_new(session_obj, "variant", json_string(game_variants[session->variant].name));
+    json_object_set_new(session_obj, "board_size", json_integer(game_variants[session->variant].board_size));
+    return session_obj;
+}
+
+char* build_game_state_message(const GameSession *session, int player_num) {
+    json_t *response = json_object();
+    json_object_set_new(response, "type", json_string("game_state"));
+    
+    const Board *player_board = (player_num == 1) ? &session->board1 : &session->board2;
+    const Board *enemy_board = (player_num == 1) ? &session->board2 : &session->board1;
+    
+    json_t *player_board_json = serialize_board(player_board);
+    json_t *enemy_board_json = serialize_board(enemy_board);
+    
+    json_object_set_new(response, "player_board", player_board_json);
+    json_object_set_new(response, "enemy_board", enemy_board_json);
+    json_object_set_new(response, "board_size", json_integer(player_board->size));
+    json_object_set_new(response, "current_player", json_integer(session->current_player));
+    json_object_set_new(response, "your_player_number", json_integer(player_num));
+    
+    char *response_str = dump_json(response);
+    json_decref(response);
+
+    return response_str;
+}
+
+char* build_public_state_message(const GameSession *session, const SessionInfo *info) {
+    static const char *state_names[] = { "waiting", "in_progress", "finished" };
+
+    char session_id_str[SESSION_ID_STR_LEN];
+    format_session_id(info->id, session_id_str);
+
+    json_t *response = json_object();
+    json_object_set_new(response, "type", json_string("public_state"));
+    json_object_set_new(response, "session_id", json_string(session_id_str));
+    json_object_set_new(response, "variant", json_string(game_variants[session->variant].name));
+    json_object_set_new(response, "state", json_string(state_names[session->state]));
+    json_object_set_new(response, "move_seq", json_integer(session->move_seq));
+    json_object_set_new(response, "player1", json_string(info->player1));
+    json_object_set_new(response, "player2", json_string(info->player2));
+    json_object_set_new(response, "current_player", json_integer(session->current_player));
+    json_object_set_new(response, "board_size", json_integer(session->board1.size));
+    json_object_set_new(response, "board1", serialize_public_board(&session->board1));
+    json_object_set_new(response, "board2", serialize_public_board(&session->board2));
+
+    char *response_str = dump_json(response);
+    json_decref(response);
+
+    return response_str;
+}
+
+static int append_json(const char *buffer, size_t size, void *data) {
+    JsonText *text = data;
+
+    if (text->len + size + 1 > text->cap) {
+        size_t cap = text->cap * 2 > text->len + size + 1 ? text->cap * 2 : text->len + size + 1;
+        char *grown = realloc(text->data, cap);
+        if (!grown) return -1;
+
+        text->data = grown;
+        text->cap = cap;
+    }
+
+    memcpy(text->data + text->len, buffer, size);
+    text->len += size;
+    return 0;
+}
+
+// Dumps through a callback so the text is always malloc'd, even when
+// jansson itself is allocating from an arena.
+char* dump_json(const json_t *root) {
+    JsonText text = { malloc(JSON_TEXT_INITIAL), 0, JSON_TEXT_INITIAL };
+    if (!text.data) return NULL;
+
+    if (json_dump_callback(root, append_json, &text, JSON_COMPACT) != 0) {
+        free(text.data);
+        return NULL;
+    }
+
+    text.data[text.len] = '\0';
+    metrics_add(METRIC_SERIALIZED_BYTES, (int64_t)text.len);
+    return text.data;
+}
@@ -0,0 +1,149 @@
+#include <string.h>
+
+#include "router.h"
+
+static int method_index(const char *method) {
+    switch (method[0]) {
+        case 'G': return strcmp(method, "GET") == 0 ? ROUTER_GET : -1;
+        case 'P':
+            if (strcmp(method, "POST") == 0) return ROUTER_POST;
+            return strcmp(method, "PUT") == 0 ? ROUTER_PUT : -1;
+        case 'D': return strcmp(method, "DELETE") == 0 ? ROUTER_DELETE : -1;
+        case 'H': return strcmp(method, "HEAD") == 0 ? ROUTER_HEAD : -1;
+        default: return -1;
+    }
+}
+
+static int new_node(Router *router, const char *segment, size_t segment_len) {
+    if (router->node_count >= ROUTER_MAX_NODES) return -1;
+
+    int id = router->node_count++;
+    RouterNode *node = &router->nodes[id];
+
+    node->segment = segment;
+    node->segment_len = segment_len;
+    node->is_param = segment_len >= 2 && segment[0] == '{' && segment[segment_len - 1] == '}';
+    node->first_child = -1;
+    node->next_sibling = -1;
+    for (int m = 0; m < ROUTER_METHOD_COUNT; m++) {
+        node->values[m] = -1;
+    }
+
+    return id;
+}
+
+// Child of parent for segment, created if missing. Parameter names do not
+// matter for matching, so all parameter segments share one child.
+static int child_for(Router *router, int parent, const char *segment, size_t segment_len) {
+    int is_param = segment_len >= 2 && segment[0] == '{' && segment[segment_len - 1] == '}';
+    int last = -1;
+
+    for (int child = router->nodes[parent].first_child; child >= 0; child = router->nodes[child].next_sibling) {
+        const RouterNode *node = &router->nodes[child];
+        if (is_param ? node->is_param :
+            (!node->is_param && node->segment_len == segment_len && memcmp(node->segment, segment, segment_len) == 0)) {
+            return child;
+        }
+        last = child;
+    }
+
+    int id = new_node(router, segment, segment_len);
+    if (id < 0) return -1;
+
+    if (last < 0) {
+        router->nodes[parent].first_child = id;
+    } else {
+        router->nodes[last].next_sibling = id;
+    }
+    return id;
+}
+
+void router_init(Router *router) {
+    router->node_count = 0;
+    new_node(router, "", 0);
+}
+
+int router_add(Router *router, const char *method, const char *pattern, int value) {
+    int m = method_index(method);
+    if (m < 0 || pattern[0] != '/') return 0;
+
+    int node = 0;
+    const char *segment = pattern + 1;
+
+    while (*segment) {
+        const char *end = strchr(segment, '/');
+        size_t segment_len = end ? (size_t)(end - segment) : strlen(segment);
+
+        node = child_for(router, node, segment, segment_len);
+        if (node < 0) return 0;
+
+        segment += segment_len;
+        if (*segment == '/') segment++;
+    }
+
+    router->nodes[node].values[m] = value;
+    return 1;
+}
+
+// Literal children are tried before the parameter child, so "/session/new"
+// can coexist with "/session/{id}".
+static int match_node(const Router *router, int node, const char *path, int depth, RouteParams *params) {
+    if (*path == '\0') return node;
+    if (depth >= ROUTER_MAX_DEPTH) return -1;
+
+    const char *segment = path;
+    const char *end = segment;
+    while (*end && *end != '/') end++;
+    size_t segment_len = (size_t)(end - segment);
+    const char *rest = *end == '/' ? end + 1 : end;
+
+    if (segment_len == 0) return -1;
+
+    int param_child = -1;
+    for (int child = router->nodes[node].first_child; child >= 0; child = router->nodes[child].next_sibling) {
+        const RouterNode *candidate = &router->nodes[child];
+
+        if (candidate->is_param) {
+            param_child = child;
+        } else if (candidate->segment_len == segment_len && memcmp(candidate->segment, segment, segment_len) == 0) {
+            int found = match_node(router, child, rest, depth + 1, params);
+            if (found >= 0) return found;
+        }
+    }
+
+    if (param_child < 0 || params->count >= ROUTER_MAX_PARAMS) return -1;
+
+    params->values[params->count++] = (RouteParam) { segment, segment_len };
+    int found = match_node(router, param_child, rest, depth + 1, params);
+    if (found < 0) params->count--;
+    return found;
+}
+
+RouteResult router_match(const Router *router, const char *method, const char *path, int *value, RouteParams *params) {
+    params->count = 0;
+    if (path[0] != '/') return ROUTE_NOT_FOUND;
+
+    int node = match_node(router, 0, path + 1, 0, params);
+    if (node < 0) return ROUTE_NOT_FOUND;
+
+    const RouterNode *matched = &router->nodes[node];
+    int m = method_index(method);
+
+    if (m < 0 || matched->values[m] < 0) {
+        for (int i = 0; i < ROUTER_METHOD_COUNT; i++) {
+            if (matched->values[i] >= 0) return ROUTE_METHOD_NOT_ALLOWED;
+        }
+        return ROUTE_NOT_FOUND;
+    }
+
+    *value = matched->values[m];
+    return ROUTE_FOUND;
+}
+
+int route_param_copy(const RouteParam *param, char *out, size_t out_size) {
+    if (param->len >= out_size) return 0;
+
+    memcpy(out, param->start, param->len);
+    out[param->len] = '\0';
+    return 1;
+}
@@ -0,0 +1,291 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/random.h>
+
+#include "session.h"
+#include "metrics.h"
+
+int fill_random(void *buf, size_t len) {
+    unsigned char *out = buf;
+
+    while (len > 0) {
+        ssize_t n = getrandom(out, len, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        out += n;
+        len -= (size_t)n;
+    }
+
+    return 1;
+}
+
+int generate_player_token(PlayerToken *token) {
+    do {
+        if (!fill_random(token, sizeof(*token))) {
+            return 0;
+        }
+    } while (session_id_is_null(*token));
+
+    return 1;
+}
+
+void format_player_token(PlayerToken token, char *out) {
+    static const char chars[] = "0123456789abcdef";
+
+    for (int i = 0; i < 16; i++) {
+        out[i] = chars[(token.hi >> (60 - 4 * i)) & 0xf];
+        out[i + 16] = chars[(token.lo >> (60 - 4 * i)) & 0xf];
+    }
+    out[PLAYER_TOKEN_STR_LEN - 1] = '\0';
+}
+
+int parse_player_token(const char *str, PlayerToken *token) {
+    if (!str) return 0;
+
+    uint64_t halves[2] = {0, 0};
+
+    for (int i = 0; i < PLAYER_TOKEN_STR_LEN - 1; i++) {
+        char c = str[i];
+
+        int value;
+        if (c >= '0' && c <= '9') value = c - '0';
+        else if (c >= 'a' && c <= 'f') value = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') value = c - 'A' + 10;
+        else return 0;
+
+        halves[i / 16] = (halves[i / 16] << 4) | (uint64_t)value;
+    }
+
+    if (str[PLAYER_TOKEN_STR_LEN - 1] != '\0') return 0;
+
+    token->hi = halves[0];
+    token->lo = halves[1];
+    return 1;
+}
+
+void format_session_id(SessionId id, char *out) {
+    static const char chars[] = "0123456789abcdef";
+    int nibble = 0;
+
+    for (int i = 0; i < SESSION_ID_STR_LEN - 1; i++) {
+        if (i == 8 || i == 13 || i == 18 || i == 23) {
+            out[i] = '-';
+            continue;
+        }
+
+        uint64_t half = (nibble < 16) ? id.hi : id.lo;
+        out[i] = chars[(half >> (60 - 4 * (nibble % 16))) & 0xf];
+        nibble++;
+    }
+    out[SESSION_ID_STR_LEN - 1] = '\0';
+}
+
+int parse_session_id(const char *str, SessionId *id) {
+    if (!str) return 0;
+
+    uint64_t halves[2] = {0, 0};
+    int nibble = 0;
+
+    for (int i = 0; i < SESSION_ID_STR_LEN - 1; i++) {
+        char c = str[i];
+
+        if (i == 8 || i == 13 || i == 18 || i == 23) {
+            if (c != '-') return 0;
+            continue;
+        }
+
+        int value;
+        if (c >= '0' && c <= '9') value = c - '0';
+        else if (c >= 'a' && c <= 'f') value = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') value = c - 'A' + 10;
+        else return 0;
+
+        halves[nibble / 16] = (halves[nibble / 16] << 4) | (uint64_t)value;
+        nibble++;
+    }
+
+    if (str[SESSION_ID_STR_LEN - 1] != '\0') return 0;
+
+    id->hi = halves[0];
+    id->lo = halves[1];
+    return 1;
+}
+
+
+
+int session_store_init(SessionStore *store, int capacity) {
+    memset(store, 0, sizeof(SessionStore));
+
+    unsigned int index_size = 16;
+    while (index_size < 2u * (unsigned int)capacity) {
+        index_size <<= 1;
+    }
+
+    size_t sessions_bytes = sizeof(GameSession) * (size_t)capacity;
+    store->sessions = aligned_alloc(_Alignof(GameSession), sessions_bytes);
+    store->infos = calloc((size_t)capacity, sizeof(SessionInfo));
+    store->index = calloc(index_size, sizeof(SessionIndexEntry));
+    store->free_slots = malloc(sizeof(int) * (size_t)capacity);
+
+    if (!store->sessions || !store->infos || !store->index || !store->free_slots) {
+        session_store_destroy(store);
+        return 0;
+    }
+
+    memset(store->sessions, 0, sessions_bytes);
+    store->index_mask = index_size - 1;
+    store->capacity = capacity;
+    store->session_count = 0;
+    store->free_count = 0;
+
+    return 1;
+}
+
+void session_store_destroy(SessionStore *store) {
+    free(store->sessions);
+    free(store->infos);
+    free(store->index);
+    free(store->free_slots);
+    memset(store, 0, sizeof(SessionStore));
+}
+
+GameSession* find_session(SessionStore *store, SessionId session_id) {
+    unsigned int slot = (unsigned int)session_id.lo & store->index_mask;
+
+    while (!session_id_is_null(store->index[slot].id)) {
+        if (session_id_equal(store->index[slot].id, session_id)) {
+            return &store->sessions[store->index[slot].session_ind];
+        }
+        slot = (slot + 1) & store->index_mask;
+    }
+    return NULL;
+}
+
+GameSession* create_session(SessionStore *store, const char *player_name, int variant) {
+    if (store->free_count == 0 && store->session_count >= store->capacity) {
+        return NULL;
+    }
+
+    SessionId id;
+    do {
+        if (!fill_random(&id, sizeof(id))) {
+            return NULL;
+        }
+    } while (session_id_is_null(id) || find_session(store, id));
+
+    PlayerToken token;
+    if (!generate_player_token(&token)) {
+        return NULL;
+    }
+
+    int session_ind = store->free_count > 0 ? store->free_slots[--store->free_count] : store->session_count++;
+    GameSession *session = &store->sessions[session_ind];
+    SessionInfo *info = &store->infos[session_ind];
+
+    info->id = id;
+    info->token1 = token;
+    strncpy(info->player1, player_name, sizeof(info->player1) - 1);
+    info->player2[0] = '\0';
+    info->created_at = time(NULL);
+
+    unsigned int slot = (unsigned int)id.lo & store->index_mask;
+    while (!session_id_is_null(store->index[slot].id)) {
+        slot = (slot + 1) & store->index_mask;
+    }
+    store->index[slot].id = id;
+    store->index[slot].session_ind = session_ind;
+
+    const GameVariant *game_variant = &game_variants[variant];
+    setup_random_board(&session->board1, game_variant);
+    init_board(&session->board2, game_variant->board_size);
+
+    session->ws1 = NULL;
+    session->ws2 = NULL;
+    session->state = WAITING_FOR_PLAYER;
+    session->current_player = 1;
+    session->variant = variant;
+    session->bot = 0;
+    session->move_seq = 0;
+
+    return session;
+}
+
+int join_session(SessionStore *store, GameSession *session, const char *player_name) {
+    if (session->state != WAITING_FOR_PLAYER) {
+        return 0;
+    }
+
+    SessionInfo *info = session_info(store, session);
+
+    if (!generate_player_token(&info->token2)) {
+        return 0;
+    }
+
+    strncpy(info->player2, player_name, sizeof(info->player2) - 1);
+    setup_random_board(&session->board2, &game_variants[session->variant]);
+    session->state = IN_PROGRESS;
+    session->move_seq++;
+    return 1;
+}
+
+// Backward-shift deletion: later entries of the probe chain move up into
+// the hole, so lookups never need tombstones.
+void remove_session(SessionStore *store, GameSession *session) {
+    int session_ind = (int)(session - store->sessions);
+    SessionInfo *info = &store->infos[session_ind];
+
+    unsigned int hole = (unsigned int)info->id.lo & store->index_mask;
+    while (!session_id_equal(store->index[hole].id, info->id)) {
+        hole = (hole + 1) & store->index_mask;
+    }
+
+    unsigned int slot = hole;
+    for (;;) {
+        slot = (slot + 1) & store->index_mask;
+        if (session_id_is_null(store->index[slot].id)) break;
+
+        unsigned int home = (unsigned int)store->index[slot].id.lo & store->index_mask;
+        // Move the entry only if its home is not cyclically within (hole, slot].
+        if (((slot - home) & store->index_mask) >= ((slot - hole) & store->index_mask)) {
+            store->index[hole] = store->index[slot];
+            hole = slot;
+        }
+    }
+    memset(&store->index[hole], 0, sizeof(SessionIndexEntry));
+
+    memset(info, 0, sizeof(SessionInfo));
+    session->ws1 = NULL;
+    session->ws2 = NULL;
+    session->state = SESSION_FREE;
+    session->move_seq++;
+
+    store->free_slots[store->free_count++] = session_ind;
+}
+
+int apply_attack(GameSession *session, int x, int y) {
+    Board *target_board = (session->current_player == 1) ? &session->board2 : &session->board1;
+
+    session->move_seq++;
+    metrics_add(METRIC_MOVES, 1);
+
+    if (check_hit(target_board, x, y)) {
+        int sunked_ship_ind = is_ship_sunk(target_board, x, y);
+
+        if (sunked_ship_ind != -1) {
+            sunk_the_ship(target_board, sunked_ship_ind);
+        }
+    } else {
+        session->current_player = (session->current_player == 1) ? 2 : 1;
+    }
+
+    if (is_game_over(target_board)) {
+        session->state = FINISHED;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include <stdlib.h>
+
+#include "spectator.h"
+#include "ws_server.h"
+#include "server.h"
+#include "protocol.h"
+#include "metrics.h"
+#include "trace.h"
+
+static SpectatorList *lists;
+
+
+
+static void unlink_client(struct ws_client *client) {
+    SpectatorList *list = client->spectating;
+
+    if (client->spectator_prev) {
+        client->spectator_prev->spectator_next = client->spectator_next;
+    } else {
+        list->head = client->spectator_next;
+    }
+    if (client->spectator_next) {
+        client->spectator_next->spectator_prev = client->spectator_prev;
+    }
+
+    client->spectating = NULL;
+    client->spectator_prev = NULL;
+    client->spectator_next = NULL;
+    metrics_add(METRIC_SPECTATORS, -1);
+}
+
+static void close_list(SpectatorList *list) {
+    while (list->head) {
+        struct ws_client *client = list->head;
+        unlink_client(client);
+        send_session_message(client->wsi, list->id, "{\"type\":\"session_closed\"}");
+    }
+}
+
+void spectator_detach(struct ws_client *client) {
+    if (client->spectating) {
+        unlink_client(client);
+    }
+}
+
+int spectator_attach(struct lws *wsi, SessionId id) {
+    if (!lists) {
+        lists = calloc((size_t)server_state.store.capacity, sizeof(SpectatorList));
+        if (!lists) return 0;
+    }
+
+    struct ws_client *client = (struct ws_client *)lws_wsi_user(wsi);
+    SessionSnapshot snapshot;
+
+    lock_server_state();
+    GameSession *session = find_session(&server_state.store, id);
+    if (!session) {
+        unlock_server_state();
+        return 0;
+    }
+    snapshot_session(&server_state.store, session, &snapshot);
+    unlock_server_state();
+
+    spectator_detach(client);
+
+    SpectatorList *list = &lists[snapshot.slot];
+    if (list->head && !session_id_equal(list->id, id)) {
+        close_list(list);
+    }
+    list->id = id;
+
+    client->spectator_next = list->head;
+    if (list->head) list->head->spectator_prev = client;
+    list->head = client;
+    client->spectating = list;
+    metrics_add(METRIC_SPECTATORS, 1);
+
+    char *text = build_public_state_message(&snapshot.session, &snapshot.info);
+    if (text) {
+        send_ws_message(wsi, text);
+        free(text);
+    }
+    return 1;
+}
+
+void spectator_publish(const SessionSnapshot *snapshot) {
+    if (!lists) return;
+
+    SpectatorList *list = &lists[snapshot->slot];
+    if (!list->head) return;
+
+    // The list still watches an earlier session that lived in this slot.
+    if (!session_id_equal(list->id, snapshot->info.id)) {
+        close_list(list);
+        return;
+    }
+
+    uint64_t serialize_start = metrics_now_ns();
+    char *text = build_public_state_message(&snapshot->session, &snapshot->info);
+    trace_span("spectator_serialize", serialize_start);
+    if (!text) return;
+
+    WsPayload *payload = ws_payload_create(text);
+    free(text);
+    if (!payload) return;
+
+    // Spectator frames are not part of the move's trace.
+    uint64_t move = trace_current_move;
+    trace_current_move = 0;
+
+    for (struct ws_client *client = list->head; client; client = client->spectator_next) {
+        int dropped = send_spectator_payload(client->wsi, payload);
+        if (dropped) metrics_add(METRIC_SPECTATOR_FRAMES_DROPPED, dropped);
+    }
+
+    trace_current_move = move;
+    ws_payload_release(payload);
+}
+
+void spectator_prune(void) {
+    if (!lists) return;
+
+    lock_server_state();
+    for (int i = 0; i < server_state.store.session_count; i++) {
+        SpectatorList *list = &lists[i];
+        if (list->head && (server_state.store.sessions[i].state == SESSION_FREE ||
+                           !session_id_equal(server_state.store.infos[i].id, list->id))) {
+            close_list(list);
+        }
+    }
+    unlock_server_state();
+}
@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+_Thread_local TraceRing *trace_thread_ring;
+_Thread_local uint64_t trace_current_move;
+
+static TraceRing *rings;
+static int ring_count;
+static pthread_mutex_t rings_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t ring_key;
+static pthread_once_t ring_key_once = PTHREAD_ONCE_INIT;
+
+static _Atomic uint64_t next_move_id = 1;
+
+
+
+static void release_ring(void *arg) {
+    TraceRing *ring = arg;
+    atomic_store(&ring->in_use, 0);
+}
+
+static void create_ring_key(void) {
+    pthread_key_create(&ring_key, release_ring);
+}
+
+// Like metrics shards, rings of exited threads are reused, keeping their spans.
+TraceRing* trace_attach_thread(void) {
+    pthread_once(&ring_key_once, create_ring_key);
+    pthread_mutex_lock(&rings_mutex);
+
+    TraceRing *ring = rings;
+    while (ring && atomic_load(&ring->in_use)) {
+        ring = ring->next;
+    }
+
+    if (!ring) {
+        ring = calloc(1, sizeof(TraceRing));
+        if (!ring) {
+            pthread_mutex_unlock(&rings_mutex);
+            abort();
+        }
+        ring->thread_slot = ++ring_count;
+        ring->next = rings;
+        rings = ring;
+    }
+
+    atomic_store(&ring->in_use, 1);
+    pthread_mutex_unlock(&rings_mutex);
+
+    pthread_setspecific(ring_key, ring);
+    trace_thread_ring = ring;
+    return ring;
+}
+
+uint64_t trace_begin_move(void) {
+    trace_current_move = atomic_fetch_add_explicit(&next_move_id, 1, memory_order_relaxed);
+    return trace_current_move;
+}
+
+
+
+static void write_ring(FILE *out, TraceRing *ring, int *first) {
+    TraceEvent *events = malloc(sizeof(ring->events));
+    if (!events) return;
+
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint64_t begin = head > TRACE_RING_EVENTS ? head - TRACE_RING_EVENTS : 0;
+    memcpy(events, ring->events, sizeof(ring->events));
+
+    // The owner kept writing during the copy; slots it may have reused are dropped.
+    uint64_t after = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (after > TRACE_RING_EVENTS && after - TRACE_RING_EVENTS > begin) {
+        begin = after - TRACE_RING_EVENTS;
+    }
+
+    for (uint64_t i = begin; i < head; i++) {
+        const TraceEvent *event = &events[i % TRACE_RING_EVENTS];
+
+        fprintf(out, "%s\n{\"name\":\"%s\",\"cat\":\"move\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+            "\"pid\":%d,\"tid\":%d,\"args\":{\"move\":%llu}}",
+            *first ? "" : ",", event->name, event->start_ns / 1e3, (event->end_ns - event->start_ns) / 1e3,
+            (int)getpid(), ring->thread_slot, (unsigned long long)event->move_id);
+        *first = 0;
+    }
+
+    free(events);
+}
+
+void trace_write(FILE *out) {
+    pthread_mutex_lock(&rings_mutex);
+    TraceRing *head = rings;
+    pthread_mutex_unlock(&rings_mutex);
+
+    int first = 1;
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (TraceRing *ring = head; ring; ring = ring->next) {
+        write_ring(out, ring, &first);
+    }
+    fprintf(out, "\n]}\n");
+}
+
+int trace_dump_file(const char *path) {
+    FILE *out = fopen(path, "w");
+    if (!out) return 0;
+
+    trace_write(out);
+    return fclose(out) == 0;
+}
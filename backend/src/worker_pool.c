@@ -0,0 +1,107 @@
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "worker_pool.h"
+
+typedef struct WorkerJob {
+    struct WorkerJob *next;
+    worker_job_fn fn;
+    void *arg;
+} WorkerJob;
+
+struct WorkerPool {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    WorkerJob *head;
+    WorkerJob *tail;
+    int stopping;
+    int thread_count;
+    pthread_t threads[];
+};
+
+static void* worker_main(void *arg) {
+    WorkerPool *pool = arg;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->mutex);
+        while (!pool->head && !pool->stopping) {
+            pthread_cond_wait(&pool->cond, &pool->mutex);
+        }
+
+        WorkerJob *job = pool->head;
+        if (!job) {
+            pthread_mutex_unlock(&pool->mutex);
+            return NULL;
+        }
+
+        pool->head = job->next;
+        if (!pool->head) pool->tail = NULL;
+        pthread_mutex_unlock(&pool->mutex);
+
+        job->fn(job->arg);
+        free(job);
+    }
+}
+
+WorkerPool* worker_pool_create(int thread_count) {
+    if (thread_count < 1) thread_count = 1;
+
+    WorkerPool *pool = calloc(1, sizeof(WorkerPool) + sizeof(pthread_t) * (size_t)thread_count);
+    if (!pool) return NULL;
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+
+    for (int i = 0; i < thread_count; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0) {
+            pool->thread_count = i;
+            worker_pool_destroy(pool);
+            return NULL;
+        }
+    }
+    pool->thread_count = thread_count;
+
+    return pool;
+}
+
+void worker_pool_destroy(WorkerPool *pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->stopping = 1;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool);
+}
+
+int worker_pool_size(const WorkerPool *pool) {
+    return pool->thread_count;
+}
+
+int worker_pool_submit(WorkerPool *pool, worker_job_fn fn, void *arg) {
+    WorkerJob *job = malloc(sizeof(WorkerJob));
+    if (!job) return 0;
+
+    job->next = NULL;
+    job->fn = fn;
+    job->arg = arg;
+
+    pthread_mutex_lock(&pool->mutex);
+    if (pool->tail) {
+        pool->tail->next = job;
+    } else {
+        pool->head = job;
+    }
+    pool->tail = job;
+    pthread_cond_signal(&pool->cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    return 1;
+}
@@ -0,0 +1,84 @@
+#include <stdlib.h>
+
+#include "ws_queue.h"
+
+void ws_payload_release(WsPayload *payload) {
+    if (payload && --payload->refs == 0) {
+        free(payload);
+    }
+}
+
+int ws_queue_push(WsSendQueue *queue, WsPayload *payload, int is_spectator, uint64_t move_id, uint64_t queued_ns) {
+    WsFrame *frame = malloc(sizeof(WsFrame));
+    if (!frame) return 0;
+
+    payload->refs++;
+    frame->next = NULL;
+    frame->payload = payload;
+    frame->move_id = move_id;
+    frame->queued_ns = queued_ns;
+    frame->is_spectator = is_spectator;
+
+    if (queue->tail) {
+        queue->tail->next = frame;
+    } else {
+        queue->head = frame;
+    }
+    queue->tail = frame;
+    queue->depth++;
+    if (is_spectator) queue->spectator_depth++;
+
+    return 1;
+}
+
+WsFrame* ws_queue_pop(WsSendQueue *queue) {
+    WsFrame *frame = queue->head;
+    if (!frame) return NULL;
+
+    queue->head = frame->next;
+    if (!queue->head) queue->tail = NULL;
+    queue->depth--;
+    if (frame->is_spectator) queue->spectator_depth--;
+
+    return frame;
+}
+
+int ws_queue_trim_spectator(WsSendQueue *queue, int limit) {
+    int dropped = 0;
+    WsFrame *previous = NULL;
+    WsFrame *frame = queue->head;
+
+    while (frame && queue->spectator_depth >= limit) {
+        WsFrame *next = frame->next;
+
+        if (!frame->is_spectator) {
+            previous = frame;
+            frame = next;
+            continue;
+        }
+
+        if (previous) {
+            previous->next = next;
+        } else {
+            queue->head = next;
+        }
+        if (queue->tail == frame) queue->tail = previous;
+        queue->depth--;
+        queue->spectator_depth--;
+
+        ws_payload_release(frame->payload);
+        free(frame);
+        dropped++;
+        frame = next;
+    }
+
+    return dropped;
+}
+
+void ws_queue_clear(WsSendQueue *queue) {
+    WsFrame *frame;
+    while ((frame = ws_queue_pop(queue))) {
+        ws_payload_release(frame->payload);
+        free(frame);
+    }
+}
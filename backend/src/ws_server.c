@@ -0,0 +1,686 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <jansson.h>
+#include <stdatomic.h>
+
+#include "ws_server.h"
+#include "server.h"
+#include "protocol.h"
+#include "bot.h"
+#include "bot_mc.h"
+#include "trace.h"
+#include "log.h"
+#include "arena.h"
+#include "matchmaking.h"
+#include "lobby.h"
+#include "spectator.h"
+
+WorkerPool *bot_pool;
+struct lws_context *ws_context;
+
+// Finished searches, drained on LWS_CALLBACK_EVENT_WAIT_CANCELLED.
+static _Atomic(MonteCarloSearch *) finished_searches;
+static atomic_int sessions_closed;
+
+// JSON of the frame or bot move being handled; reset after each.
+static _Alignas(ARENA_ALIGN) unsigned char message_arena_initial[16384];
+static Arena message_arena = {
+    .ptr = message_arena_initial,
+    .end = message_arena_initial + sizeof(message_arena_initial),
+    .initial = message_arena_initial,
+    .initial_size = sizeof(message_arena_initial),
+};
+
+
+
+/*
+    Queues a copy of the message; it is written on LWS_CALLBACK_SERVER_WRITEABLE,
+    one frame per callback, as lws requires.
+*/
+void send_ws_message(struct lws *wsi, const char *message) {
+    if (!wsi) return;
+
+    WsPayload *payload = ws_payload_create(message);
+    if (!payload) return;
+
+    send_ws_payload(wsi, payload);
+    ws_payload_release(payload);
+}
+
+WsPayload* ws_payload_create(const char *message) {
+    size_t len = strlen(message);
+
+    WsPayload *payload = malloc(sizeof(WsPayload) + LWS_PRE + len);
+    if (!payload) return NULL;
+
+    payload->refs = 1;
+    payload->len = len;
+    memcpy(&payload->data[LWS_PRE], message, len);
+    return payload;
+}
+
+WsPayload* ws_payload_create_tagged(const char *message, SessionId session_id) {
+    char session_id_str[SESSION_ID_STR_LEN];
+    format_session_id(session_id, session_id_str);
+
+    // Splices the field in after the opening brace; message must be a JSON object.
+    char prefix[SESSION_ID_STR_LEN + 20];
+    int prefix_len = snprintf(prefix, sizeof(prefix), "{\"session_id\":\"%s\"%s", session_id_str, message[1] == '}' ? "" : ",");
+    size_t rest_len = strlen(message) - 1;
+
+    WsPayload *payload = malloc(sizeof(WsPayload) + LWS_PRE + (size_t)prefix_len + rest_len);
+    if (!payload) return NULL;
+
+    payload->refs = 1;
+    payload->len = (size_t)prefix_len + rest_len;
+    memcpy(&payload->data[LWS_PRE], prefix, (size_t)prefix_len);
+    memcpy(&payload->data[LWS_PRE + prefix_len], message + 1, rest_len);
+    return payload;
+}
+
+static void queue_ws_payload(struct lws *wsi, WsPayload *payload, int is_spectator) {
+    struct ws_client *client = (struct ws_client *)lws_wsi_user(wsi);
+
+    if (!ws_queue_push(&client->send_queue, payload, is_spectator,
+                       trace_current_move, trace_current_move ? metrics_now_ns() : 0)) {
+        return;
+    }
+    metrics_add(METRIC_WS_SEND_QUEUE_DEPTH, 1);
+
+    lws_callback_on_writable(wsi);
+}
+
+void send_ws_payload(struct lws *wsi, WsPayload *payload) {
+    if (!wsi) return;
+
+    queue_ws_payload(wsi, payload, 0);
+}
+
+int send_spectator_payload(struct lws *wsi, WsPayload *payload) {
+    struct ws_client *client = (struct ws_client *)lws_wsi_user(wsi);
+
+    int dropped = ws_queue_trim_spectator(&client->send_queue, SPECTATOR_QUEUE_LIMIT);
+    metrics_add(METRIC_WS_SEND_QUEUE_DEPTH, -dropped);
+
+    queue_ws_payload(wsi, payload, 1);
+    return dropped;
+}
+
+static void free_send_queue(struct ws_client *client) {
+    metrics_add(METRIC_WS_SEND_QUEUE_DEPTH, -client->send_queue.depth);
+    ws_queue_clear(&client->send_queue);
+}
+
+void send_session_message(struct lws *wsi, SessionId session_id, const char *message) {
+    if (!wsi) return;
+
+    WsPayload *payload = ws_payload_create_tagged(message, session_id);
+    if (!payload) return;
+
+    send_ws_payload(wsi, payload);
+    ws_payload_release(payload);
+}
+
+static void send_player_state(struct lws *wsi, const GameSession *session, SessionId session_id, int player_num) {
+    if (!wsi) return;
+
+    uint64_t serialize_start = metrics_now_ns();
+    char *response_str = build_game_state_message(session, player_num);
+    trace_span("serialize", serialize_start);
+
+    if (response_str) {
+        send_session_message(wsi, session_id, response_str);
+        free(response_str);
+    }
+}
+
+void send_game_state(GameSession *session, int player_num) {
+    struct lws *wsi = (player_num == 1) ? session->ws1 : session->ws2;
+    send_player_state(wsi, session, session_info(&server_state.store, session)->id, player_num);
+}
+
+
+
+static WsSeat* find_seat(struct ws_client *client, const GameSession *session, int player_num) {
+    for (int i = 0; i < client->seat_count; i++) {
+        if (client->seats[i].session == session && client->seats[i].player_num == player_num) {
+            return &client->seats[i];
+        }
+    }
+    return NULL;
+}
+
+static void remove_seat(struct ws_client *client, WsSeat *seat) {
+    *seat = client->seats[--client->seat_count];
+}
+
+/*
+    Seat a message is about: the one named by its "session_id", or the only
+    seat when it names none. Of two seats in one session, the one whose
+    turn it is wins.
+*/
+static WsSeat* select_seat(struct ws_client *client, const json_t *root) {
+    json_t *session_id_json = json_object_get(root, "session_id");
+
+    if (!session_id_json) {
+        return (client->seat_count == 1 && client->seats[0].session) ? &client->seats[0] : NULL;
+    }
+
+    SessionId session_id;
+    if (!parse_session_id(json_string_value(session_id_json), &session_id)) {
+        return NULL;
+    }
+
+    WsSeat *found = NULL;
+    for (int i = 0; i < client->seat_count; i++) {
+        WsSeat *seat = &client->seats[i];
+        if (!seat->session || !session_id_equal(seat->id, session_id)) continue;
+
+        if (!found || seat->player_num == seat->session->current_player) {
+            found = seat;
+        }
+    }
+    return found;
+}
+
+void close_session_clients(GameSession *session) {
+    struct lws *sockets[2] = { session->ws1, session->ws2 };
+
+    for (int i = 0; i < 2; i++) {
+        if (!sockets[i]) continue;
+
+        struct ws_client *client = (struct ws_client *)lws_wsi_user(sockets[i]);
+        WsSeat *seat = find_seat(client, session, i + 1);
+        if (seat) {
+            seat->session = NULL;
+            atomic_store(&client->session_closed, 1);
+        }
+    }
+
+    session->ws1 = NULL;
+    session->ws2 = NULL;
+}
+
+void notify_closed_sessions(void) {
+    atomic_store(&sessions_closed, 1);
+    lws_cancel_service(ws_context);
+}
+
+// Reports and drops the seats close_session_clients cleared.
+static void report_closed_seats(struct ws_client *client, struct lws *wsi) {
+    lock_server_state();
+
+    int i = 0;
+    while (i < client->seat_count) {
+        if (client->seats[i].session) {
+            i++;
+            continue;
+        }
+        send_session_message(wsi, client->seats[i].id, "{\"type\":\"session_closed\"}");
+        remove_seat(client, &client->seats[i]);
+    }
+
+    unlock_server_state();
+}
+
+int bind_ws_client(struct lws *wsi, GameSession *session, int player_num) {
+    struct ws_client *client = (struct ws_client *)lws_wsi_user(wsi);
+    struct lws **slot = (player_num == 1) ? &session->ws1 : &session->ws2;
+
+    WsSeat *seat = find_seat(client, session, player_num);
+    if (!seat) {
+        if (client->seat_count == client->seat_cap) {
+            int cap = client->seat_cap ? client->seat_cap * 2 : 4;
+            if (cap > WS_MAX_SEATS) return 0;
+
+            WsSeat *grown = realloc(client->seats, sizeof(WsSeat) * (size_t)cap);
+            if (!grown) return 0;
+
+            client->seats = grown;
+            client->seat_cap = cap;
+        }
+
+        seat = &client->seats[client->seat_count++];
+        seat->session = session;
+        seat->id = session_info(&server_state.store, session)->id;
+        seat->player_num = player_num;
+    }
+
+    if (*slot && *slot != wsi) {
+        struct ws_client *previous = (struct ws_client *)lws_wsi_user(*slot);
+        WsSeat *previous_seat = find_seat(previous, session, player_num);
+        if (previous_seat) {
+            send_session_message(*slot, previous_seat->id, "{\"type\":\"seat_taken\"}");
+            remove_seat(previous, previous_seat);
+        }
+    }
+
+    *slot = wsi;
+    return 1;
+}
+
+void unbind_ws_seat(struct lws *wsi, GameSession *session, int player_num) {
+    struct ws_client *client = (struct ws_client *)lws_wsi_user(wsi);
+    struct lws **slot = (player_num == 1) ? &session->ws1 : &session->ws2;
+
+    WsSeat *seat = find_seat(client, session, player_num);
+    if (seat) remove_seat(client, seat);
+    if (*slot == wsi) *slot = NULL;
+}
+
+/*
+    Leaves every seat, telling the opponents that are still connected. A
+    session still waiting for its second player is abandoned with its host
+    and leaves the lobby.
+*/
+static void unbind_ws_client(struct ws_client *client, struct lws *wsi) {
+    for (int i = 0; i < client->seat_count; i++) {
+        WsSeat *seat = &client->seats[i];
+        GameSession *session = seat->session;
+        if (!session) continue;
+
+        struct lws **own = (seat->player_num == 1) ? &session->ws1 : &session->ws2;
+        struct lws *opponent_wsi = (seat->player_num == 1) ? session->ws2 : session->ws1;
+        if (*own != wsi) continue;
+        *own = NULL;
+
+        if (session->state == WAITING_FOR_PLAYER) {
+            lobby_session_removed(seat->id);
+            session->state = FINISHED;
+            session->move_seq++;
+        }
+
+        if (opponent_wsi && opponent_wsi != wsi) {
+            send_session_message(opponent_wsi, seat->id, "{\"type\":\"player_left\"}");
+        }
+    }
+
+    free(client->seats);
+    client->seats = NULL;
+    client->seat_count = 0;
+    client->seat_cap = 0;
+}
+
+/*
+    Sends a move's result from a snapshot taken under the lock, so the live
+    session, which an HTTP thread may remove meanwhile, is not read.
+*/
+void send_attack_outcome(const SessionSnapshot *snapshot, int game_over) {
+    const GameSession *session = &snapshot->session;
+
+    if (game_over) {
+        json_t *game_over_msg = json_object();
+        json_object_set_new(game_over_msg, "type", json_string("attack_result"));
+        json_object_set_new(game_over_msg, "game_over", json_boolean(true));
+        json_object_set_new(game_over_msg, "next_player", json_integer(session->current_player));
+        
+        uint64_t serialize_start = metrics_now_ns();
+        char *game_over_str = dump_json(game_over_msg);
+        trace_span("serialize", serialize_start);
+        
+        WsPayload *payload = game_over_str ? ws_payload_create_tagged(game_over_str, snapshot->info.id) : NULL;
+        if (payload) {
+            // One socket may hold both seats; it gets the result once.
+            send_ws_payload(session->ws1, payload);
+            if (session->ws2 != session->ws1) send_ws_payload(session->ws2, payload);
+            ws_payload_release(payload);
+        }
+        
+        free(game_over_str);
+        json_decref(game_over_msg);
+    } else {
+        send_player_state(session->ws1, session, snapshot->info.id, 1);
+        send_player_state(session->ws2, session, snapshot->info.id, 2);
+    }
+
+    spectator_publish(snapshot);
+}
+
+static void on_search_done(MonteCarloSearch *search) {
+    MonteCarloSearch *head = atomic_load(&finished_searches);
+    do {
+        search->next = head;
+    } while (!atomic_compare_exchange_weak(&finished_searches, &head, search));
+
+    lws_cancel_service(ws_context);
+}
+
+/* Called with server_state.mutex held, when it is the bot's turn. */
+void start_bot_move(GameSession *session) {
+    MonteCarloSearch *search = mc_search_create(&session->board1);
+    if (!search) {
+        uint32_t seq_before = session->move_seq;
+        play_bot_turn(session);
+        metrics_add(METRIC_BOT_MOVES, session->move_seq - seq_before);
+        return;
+    }
+
+    search->session_id = session_info(&server_state.store, session)->id;
+    search->move_seq = session->move_seq;
+
+    mc_search_submit(bot_pool, search, MC_BOT_BUDGET_US, on_search_done);
+}
+
+/*
+    Applies finished searches. A search is dropped if its game moved on
+    while it ran, e.g. the player left.
+*/
+void apply_finished_searches(void) {
+    MonteCarloSearch *search = atomic_exchange(&finished_searches, NULL);
+    Arena *previous_arena = arena_enter(&message_arena);
+
+    while (search) {
+        MonteCarloSearch *next = search->next;
+        SessionSnapshot snapshot;
+        int applied = 0;
+        int game_over = 0;
+        uint64_t started = metrics_now_ns();
+
+        trace_begin_move();
+        lock_server_state();
+        trace_span("lock_wait", started);
+
+        uint64_t lookup_start = metrics_now_ns();
+        GameSession *candidate = find_session(&server_state.store, search->session_id);
+        trace_span("lookup", lookup_start);
+
+        if (candidate && candidate->state == IN_PROGRESS && candidate->current_player == 2 &&
+            candidate->move_seq == search->move_seq && search->x >= 0) {
+            uint64_t logic_start = metrics_now_ns();
+            game_over = apply_attack(candidate, search->x, search->y);
+            metrics_add(METRIC_BOT_MOVES, 1);
+
+            if (!game_over && candidate->current_player == 2) {
+                start_bot_move(candidate);
+            }
+            game_over = game_over || candidate->state == FINISHED;
+            snapshot_session(&server_state.store, candidate, &snapshot);
+            applied = 1;
+            trace_span("logic", logic_start);
+        }
+
+        unlock_server_state();
+
+        if (applied) {
+            send_attack_outcome(&snapshot, game_over);
+        }
+
+        trace_span("bot_move", started);
+        trace_end_move();
+
+        free(search);
+        arena_reset(&message_arena);
+        search = next;
+    }
+
+    arena_leave(previous_arena);
+}
+
+
+
+static void handle_ws_message(struct lws *wsi, struct ws_client *client, const char *message, size_t len) {
+    uint64_t received_at = metrics_now_ns();
+    LOG_RATE_LIMITED(LOG_DEBUG, 100, "ws_received", "wsi=%p len=%zu body=%.*s",
+        (void *)wsi, len, (int)(len < 128 ? len : 128), message);
+
+    json_error_t error;
+
+    json_t *root = json_loadb(message, len, 0, &error);
+    if (!root) {
+        LOG_RATE_LIMITED(LOG_WARN, 10, "ws_bad_json", "wsi=%p error=\"%s\"", (void *)wsi, error.text);
+        return;
+    }
+
+    json_t *type_json = json_object_get(root, "type");
+    if (!json_is_string(type_json)) {
+        json_decref(root);
+        return;
+    }
+
+    const char *type = json_string_value(type_json);
+    if (strcmp(type, "attack") == 0) {
+        json_t *x_json = json_object_get(root, "x");
+        json_t *y_json = json_object_get(root, "y");
+
+        if (!json_is_integer(x_json) || !json_is_integer(y_json)) {
+            json_decref(root);
+            return;
+        }
+
+        int x = json_integer_value(x_json);
+        int y = json_integer_value(y_json);
+        uint64_t move_start = metrics_now_ns();
+
+        trace_begin_move();
+        trace_span("parse", received_at);
+
+        lock_server_state();
+        trace_span("lock_wait", move_start);
+
+        uint64_t lookup_start = metrics_now_ns();
+        WsSeat *seat = select_seat(client, root);
+        GameSession *session = seat ? seat->session : NULL;
+
+        if (!session || session->state != IN_PROGRESS || session->current_player != seat->player_num) {
+            unlock_server_state();
+            trace_end_move();
+            json_decref(root);
+            return;
+        }
+        trace_span("lookup", lookup_start);
+
+        uint64_t logic_start = metrics_now_ns();
+        int game_over = apply_attack(session, x, y);
+        if (!game_over && session->bot == BOT_MONTE_CARLO) {
+            if (session->current_player == 2) {
+                start_bot_move(session);
+            }
+        } else if (!game_over && session->bot) {
+            uint32_t seq_before = session->move_seq;
+            game_over = play_bot_turn(session);
+            metrics_add(METRIC_BOT_MOVES, session->move_seq - seq_before);
+        }
+
+        SessionSnapshot snapshot;
+        snapshot_session(&server_state.store, session, &snapshot);
+        trace_span("logic", logic_start);
+
+        unlock_server_state();
+
+        send_attack_outcome(&snapshot, game_over);
+        metrics_observe(METRIC_MOVE_DURATION, metrics_now_ns() - move_start);
+
+        trace_span("attack", received_at);
+        trace_end_move();
+    } else if (strcmp(type, "join") == 0) {
+        json_t *session_id_json = json_object_get(root, "session_id");
+        json_t *token_json = json_object_get(root, "token");
+
+        SessionId session_id;
+        PlayerToken token;
+
+        if (!parse_session_id(json_string_value(session_id_json), &session_id) ||
+            !parse_player_token(json_string_value(token_json), &token)) {
+            json_decref(root);
+            return;
+        }
+
+        lock_server_state();
+
+        GameSession *session = find_session(&server_state.store, session_id);
+        SessionSnapshot snapshot;
+        int joined = 0;
+
+        if (session) {
+            int player_num = 0;
+            SessionInfo *info = session_info(&server_state.store, session);
+
+            if (player_token_matches(info->token1, token)) {
+                player_num = 1;
+            } else if (session->state != WAITING_FOR_PLAYER && player_token_matches(info->token2, token)) {
+                player_num = 2;
+            }
+
+            if (player_num > 0 && bind_ws_client(wsi, session, player_num)) {
+                send_game_state(session, player_num);
+                snapshot_session(&server_state.store, session, &snapshot);
+                joined = 1;
+            }
+        }
+        
+        unlock_server_state();
+
+        if (joined) {
+            spectator_publish(&snapshot);
+        }
+    } else if (strcmp(type, "quickmatch") == 0) {
+        json_t *ticket_json = json_object_get(root, "ticket");
+        json_t *player_name_json = json_object_get(root, "player_name");
+        json_t *variant_json = json_object_get(root, "variant");
+
+        int accepted = 0;
+        if (ticket_json) {
+            PlayerToken ticket;
+            accepted = parse_player_token(json_string_value(ticket_json), &ticket) && quickmatch_claim(wsi, ticket);
+        } else if (json_is_string(player_name_json)) {
+            int variant = VARIANT_CLASSIC;
+            if (variant_json) {
+                variant = json_is_string(variant_json) ? find_game_variant(json_string_value(variant_json)) : -1;
+            }
+            accepted = variant >= 0 && quickmatch_join(wsi, json_string_value(player_name_json), variant);
+        }
+
+        if (!accepted) {
+            send_ws_message(wsi, "{\"type\":\"quickmatch_failed\"}");
+        }
+    } else if (strcmp(type, "spectate") == 0) {
+        SessionId session_id;
+        if (!parse_session_id(json_string_value(json_object_get(root, "session_id")), &session_id) ||
+            !spectator_attach(wsi, session_id)) {
+            send_ws_message(wsi, "{\"type\":\"spectate_failed\"}");
+        }
+    } else if (strcmp(type, "stop_spectating") == 0) {
+        spectator_detach(client);
+    } else if (strcmp(type, "subscribe_lobby") == 0) {
+        lobby_subscribe(wsi);
+    } else if (strcmp(type, "unsubscribe_lobby") == 0) {
+        lobby_unsubscribe(wsi);
+    } else if (strcmp(type, "leave") == 0) {
+        lock_server_state();
+        WsSeat *seat = select_seat(client, root);
+        GameSession *session = seat ? seat->session : NULL;
+        SessionSnapshot snapshot;
+        if (session) {
+            struct lws **own = (seat->player_num == 1) ? &session->ws1 : &session->ws2;
+            struct lws *opponent_wsi = (seat->player_num == 1) ? session->ws2 : session->ws1;
+
+            if (session->state == WAITING_FOR_PLAYER) {
+                lobby_session_removed(seat->id);
+            }
+            session->state = FINISHED;
+            session->move_seq++;
+
+            if (*own == wsi) *own = NULL;
+            if (opponent_wsi && opponent_wsi != wsi) {
+                send_session_message(opponent_wsi, seat->id, "{\"type\":\"player_left\"}");
+            }
+
+            snapshot_session(&server_state.store, session, &snapshot);
+            remove_seat(client, seat);
+        }
+        unlock_server_state();
+
+        if (session) {
+            spectator_publish(&snapshot);
+        }
+    }
+
+    json_decref(root);
+}
+
+
+
+struct lws_protocols protocols[] = {
+    {
+        "battleship-protocol",
+        callback_battleship,
+        sizeof(struct ws_client),
+        4096,
+        0, NULL, 0
+    },
+    {NULL, NULL, 0, 0, 0, NULL, 0 }
+};
+
+int callback_battleship(struct lws *wsi, enum lws_callback_reasons reason, void *user, void *in, size_t len) {
+    struct ws_client *client = (struct ws_client *)user;
+
+    switch (reason) {
+        case LWS_CALLBACK_ESTABLISHED:
+            LOG(LOG_DEBUG, "ws_connected", "wsi=%p", (void *)wsi);
+            client->wsi = wsi;
+            metrics_add(METRIC_WS_CONNECTIONS, 1);
+            break;
+
+        case LWS_CALLBACK_SERVER_WRITEABLE: {
+            if (atomic_exchange(&client->session_closed, 0)) {
+                report_closed_seats(client, wsi);
+            }
+
+            WsFrame *frame = ws_queue_pop(&client->send_queue);
+            if (!frame) break;
+            metrics_add(METRIC_WS_SEND_QUEUE_DEPTH, -1);
+
+            uint64_t write_start = metrics_now_ns();
+            int written = lws_write(wsi, &frame->payload->data[LWS_PRE], frame->payload->len, LWS_WRITE_TEXT);
+
+            if (frame->move_id) {
+                trace_record("send_queue", frame->move_id, frame->queued_ns, write_start);
+                trace_record("send", frame->move_id, write_start, metrics_now_ns());
+            }
+            ws_payload_release(frame->payload);
+            free(frame);
+
+            if (written < 0) return -1;
+            if (client->send_queue.head) lws_callback_on_writable(wsi);
+            break;
+        }
+
+        case LWS_CALLBACK_RECEIVE: {
+            // Frames are handled one at a time, so one arena serves them all.
+            Arena *previous_arena = arena_enter(&message_arena);
+            handle_ws_message(wsi, client, (const char *)in, len);
+            arena_leave(previous_arena);
+            arena_reset(&message_arena);
+            break;
+        }
+
+        case LWS_CALLBACK_EVENT_WAIT_CANCELLED:
+            apply_finished_searches();
+            lobby_flush();
+            if (atomic_exchange(&sessions_closed, 0)) {
+                spectator_prune();
+                lws_callback_on_writable_all_protocol(ws_context, &protocols[0]);
+            }
+            break;
+
+        case LWS_CALLBACK_CLOSED: {
+            LOG(LOG_DEBUG, "ws_closed", "wsi=%p queued=%d", (void *)wsi, client->send_queue.depth);
+            metrics_add(METRIC_WS_CONNECTIONS, -1);
+            free_send_queue(client);
+            quickmatch_cancel(wsi);
+            lobby_unsubscribe(wsi);
+            spectator_detach(client);
+
+            lock_server_state();
+            unbind_ws_client(client, wsi);
+            unlock_server_state();
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    return 0;
+}
@@ -0,0 +1,236 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "bitboard.h"
+#include "game.h"
+
+#define RANDOM_BOARDS 200000
+#define KERNEL_BOARDS 2000
+#define PLACEMENT_QUERIES 64
+
+/*
+    Checks every dilate_rows variant the CPU can run against a plain
+    neighbourhood scan over random rows and masks, then runs the
+    per-size can_place_ship and sunk_the_ship kernels on top of it against
+    the cell-scan versions they replaced.
+*/
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ull;
+
+static inline uint32_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)(rng_state >> 32);
+}
+
+static int cell(const BoardRow *rows, int x, int y) {
+    if (x < 0 || x >= 16 || y < 0 || y >= BOARD_ROWS) return 0;
+    return (rows[y] >> x) & 1;
+}
+
+static void dilate_rows_reference(const BoardRow *rows, const BoardRow *mask, BoardRow *out) {
+    for (int y = 0; y < BOARD_ROWS; y++) {
+        out[y] = 0;
+        for (int x = 0; x < 16; x++) {
+            int near = 0;
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    near |= cell(rows, x + dx, y + dy);
+                }
+            }
+            if (near && cell(mask, x, y)) out[y] |= (BoardRow)(1u << x);
+        }
+    }
+}
+
+// Sparse boards look like real games, dense ones hit every carry path.
+static void random_rows(BoardRow *rows, int density) {
+    for (int y = 0; y < BOARD_ROWS; y++) {
+        BoardRow row = (BoardRow)next_random();
+        for (int i = 0; i < density; i++) {
+            row &= (BoardRow)next_random();
+        }
+        rows[y] = row;
+    }
+}
+
+static int check_variant(const char *name, dilate_rows_fn fn) {
+    rng_state = 0x9e3779b97f4a7c15ull;
+
+    for (int i = 0; i < RANDOM_BOARDS; i++) {
+        BoardRow rows[BOARD_ROWS], mask[BOARD_ROWS];
+        BoardRow expected[BOARD_ROWS], actual[BOARD_ROWS];
+
+        random_rows(rows, i % 4);
+        random_rows(mask, (i / 4) % 2);
+
+        dilate_rows_reference(rows, mask, expected);
+        fn(rows, mask, actual);
+
+        for (int y = 0; y < BOARD_ROWS; y++) {
+            if (expected[y] != actual[y]) {
+                printf("test=dilate_rows impl=%s result=FAIL board=%d row=%d expected=%04x actual=%04x\n",
+                    name, i, y, expected[y], actual[y]);
+                return 1;
+            }
+        }
+    }
+
+    printf("test=dilate_rows impl=%s boards=%d result=ok\n", name, RANDOM_BOARDS);
+    return 0;
+}
+
+static int can_place_ship_reference(const Board *board, int x, int y, int size, int horizontal) {
+    int n = board->size;
+
+    if (horizontal ? x + size > n : y + size > n) return 0;
+
+    int end_x = horizontal ? x + size : x + 1;
+    int end_y = horizontal ? y + 1 : y + size;
+
+    for (int i = x - 1; i <= end_x; i++) {
+        for (int j = y - 1; j <= end_y; j++) {
+            if (i >= 0 && i < n && j >= 0 && j < n && ((board->ship_rows[j] >> i) & 1)) return 0;
+        }
+    }
+    return 1;
+}
+
+static void sunk_the_ship_reference(Board *board, int ship_ind) {
+    const Ship *ship = &board->ships[ship_ind];
+    int n = board->size;
+    int end_x = ship->is_horizontal ? ship->x + ship->size : ship->x + 1;
+    int end_y = ship->is_horizontal ? ship->y + 1 : ship->y + ship->size;
+
+    for (int x = ship->x - 1; x <= end_x; x++) {
+        for (int y = ship->y - 1; y <= end_y; y++) {
+            if (x >= 0 && x < n && y >= 0 && y < n) {
+                board->shot_rows[y] |= (BoardRow)(1u << x);
+            }
+        }
+    }
+}
+
+static int rows_within(const BoardRow *rows, int n) {
+    BoardRow outside = (BoardRow)~((1u << n) - 1);
+    for (int y = 0; y < BOARD_ROWS; y++) {
+        if ((y >= n && rows[y]) || (rows[y] & outside)) return 0;
+    }
+    return 1;
+}
+
+// Starts half the ships on an edge or in a corner, where the masks matter most.
+static void random_placement(int n, int size, int *x, int *y, int *horizontal) {
+    *horizontal = (int)(next_random() & 1);
+    int span = n - size;
+
+    switch (next_random() % 8) {
+        case 0: *x = 0; *y = (int)(next_random() % n); break;
+        case 1: *x = *horizontal ? span : n - 1; *y = (int)(next_random() % n); break;
+        case 2: *x = (int)(next_random() % n); *y = *horizontal ? n - 1 : span; break;
+        case 3:
+            *x = (next_random() & 1) ? 0 : (*horizontal ? span : n - 1);
+            *y = (next_random() & 1) ? 0 : (*horizontal ? n - 1 : span);
+            break;
+        default: *x = (int)(next_random() % n); *y = (int)(next_random() % n); break;
+    }
+}
+
+static int fail_kernel(const char *impl, const char *kernel, int n, int board, int x, int y, int size, int horizontal) {
+    printf("test=%s impl=%s size=%d result=FAIL board=%d x=%d y=%d ship=%d horizontal=%d\n",
+        kernel, impl, n, board, x, y, size, horizontal);
+    return 1;
+}
+
+/*
+    Builds boards ship by ship with the reference check, asks both versions
+    about random placements along the way, then sinks every ship both ways
+    and compares the marked halos.
+*/
+static int check_kernels(const char *impl, const GameVariant *variant) {
+    int n = variant->board_size;
+    rng_state = 0x2545f4914f6cdd1dull ^ (uint64_t)n;
+
+    for (int b = 0; b < KERNEL_BOARDS; b++) {
+        Board board;
+        init_board(&board, n);
+
+        for (int i = 0; i < variant->ship_count; i++) {
+            for (int q = 0; q < PLACEMENT_QUERIES; q++) {
+                int x, y, horizontal;
+                int size = variant->fleet[(i + q) % variant->ship_count];
+                random_placement(n, size, &x, &y, &horizontal);
+
+                if (can_place_ship(&board, x, y, size, horizontal) != can_place_ship_reference(&board, x, y, size, horizontal)) {
+                    return fail_kernel(impl, "can_place_ship", n, b, x, y, size, horizontal);
+                }
+            }
+
+            for (int attempt = 0; attempt < 1000; attempt++) {
+                int x, y, horizontal;
+                random_placement(n, variant->fleet[i], &x, &y, &horizontal);
+                if (can_place_ship_reference(&board, x, y, variant->fleet[i], horizontal)) {
+                    place_ship(&board, x, y, variant->fleet[i], horizontal);
+                    break;
+                }
+            }
+        }
+
+        if (!rows_within(board.ship_rows, n)) {
+            return fail_kernel(impl, "place_ship", n, b, -1, -1, 0, 0);
+        }
+
+        for (int i = 0; i < board.ship_count; i++) {
+            const Ship *ship = &board.ships[i];
+            Board expected = board;
+            Board actual = board;
+
+            sunk_the_ship_reference(&expected, i);
+            sunk_the_ship(&actual, i);
+
+            if (memcmp(expected.shot_rows, actual.shot_rows, sizeof(expected.shot_rows)) != 0 ||
+                !rows_within(actual.shot_rows, n)) {
+                return fail_kernel(impl, "sunk_the_ship", n, b, ship->x, ship->y, ship->size, ship->is_horizontal);
+            }
+        }
+    }
+
+    printf("test=board_kernels impl=%s size=%d boards=%d result=ok\n", impl, n, KERNEL_BOARDS);
+    return 0;
+}
+
+// Points dilate_rows, which the board kernels call, at fn for every check.
+static int check_impl(const char *name, dilate_rows_fn fn) {
+    dilate_rows_fn previous = dilate_rows;
+    dilate_rows = fn;
+
+    int failed = check_variant(name, fn);
+    for (int v = 0; v < VARIANT_COUNT; v++) {
+        failed |= check_kernels(name, &game_variants[v]);
+    }
+
+    dilate_rows = previous;
+    return failed;
+}
+
+int main(void) {
+    int failed = check_impl("scalar", dilate_rows_scalar);
+
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        failed |= check_impl("sse2", dilate_rows_sse2);
+    } else {
+        printf("test=dilate_rows impl=sse2 result=skipped\n");
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        failed |= check_impl("avx2", dilate_rows_avx2);
+    } else {
+        printf("test=dilate_rows impl=avx2 result=skipped\n");
+    }
+#endif
+
+    return failed;
+}
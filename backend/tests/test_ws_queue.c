@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ws_queue.h"
+
+#define GAME_FRAMES 8
+#define SPECTATOR_FRAMES 50
+
+/*
+    A socket that plays one session and spectates another shares one send
+    queue between both. It stops reading while its game frames and a
+    stream of spectator snapshots pile up; every game frame must survive,
+    in order, and only the newest snapshots may stay queued.
+*/
+
+static int failures;
+
+static void expect(int ok, const char *what) {
+    if (!ok) {
+        printf("test=ws_queue result=FAIL check=\"%s\"\n", what);
+        failures++;
+    }
+}
+
+static WsPayload* make_payload(const char *text) {
+    size_t len = strlen(text);
+    WsPayload *payload = malloc(sizeof(WsPayload) + len + 1);
+    payload->refs = 1;
+    payload->len = len;
+    memcpy(payload->data, text, len + 1);
+    return payload;
+}
+
+static void push_text(WsSendQueue *queue, const char *text, int is_spectator) {
+    WsPayload *payload = make_payload(text);
+
+    if (is_spectator) {
+        ws_queue_trim_spectator(queue, SPECTATOR_QUEUE_LIMIT);
+    }
+    ws_queue_push(queue, payload, is_spectator, 0, 0);
+    ws_payload_release(payload);
+}
+
+int main(void) {
+    WsSendQueue queue = {0};
+    char text[32];
+    int game_sent = 0;
+
+    // Game frames interleaved with snapshots, as a busy socket would see them.
+    for (int i = 0; i < SPECTATOR_FRAMES; i++) {
+        if (i % (SPECTATOR_FRAMES / GAME_FRAMES) == 0 && game_sent < GAME_FRAMES) {
+            snprintf(text, sizeof(text), "game %d", game_sent++);
+            push_text(&queue, text, 0);
+        }
+        snprintf(text, sizeof(text), "spectate %d", i);
+        push_text(&queue, text, 1);
+        expect(queue.spectator_depth <= SPECTATOR_QUEUE_LIMIT, "spectator frames stay under the limit");
+    }
+
+    expect(game_sent == GAME_FRAMES, "every game frame was queued");
+    expect(queue.depth == GAME_FRAMES + SPECTATOR_QUEUE_LIMIT, "depth counts kept game frames and newest snapshots");
+    expect(queue.spectator_depth == SPECTATOR_QUEUE_LIMIT, "spectator depth is at the limit");
+
+    int next_game = 0;
+    int next_spectate = SPECTATOR_FRAMES - SPECTATOR_QUEUE_LIMIT;
+    WsFrame *frame;
+
+    while ((frame = ws_queue_pop(&queue))) {
+        if (frame->is_spectator) {
+            snprintf(text, sizeof(text), "spectate %d", next_spectate++);
+        } else {
+            snprintf(text, sizeof(text), "game %d", next_game++);
+        }
+        expect(strcmp((const char *)frame->payload->data, text) == 0, "frames leave in order");
+
+        ws_payload_release(frame->payload);
+        free(frame);
+    }
+
+    expect(next_game == GAME_FRAMES, "no game frame was dropped");
+    expect(next_spectate == SPECTATOR_FRAMES, "only the newest snapshots were kept");
+    expect(queue.head == NULL && queue.tail == NULL && queue.depth == 0 && queue.spectator_depth == 0, "queue drains empty");
+
+    // Trimming a queue holding only game frames drops nothing.
+    for (int i = 0; i < SPECTATOR_QUEUE_LIMIT * 2; i++) {
+        push_text(&queue, "game", 0);
+    }
+    expect(ws_queue_trim_spectator(&queue, SPECTATOR_QUEUE_LIMIT) == 0, "game frames are never trimmed");
+    expect(ws_queue_trim_spectator(&queue, 0) == 0, "game frames are never trimmed, even at limit 0");
+    expect(queue.depth == SPECTATOR_QUEUE_LIMIT * 2, "game frames all stay queued");
+    ws_queue_clear(&queue);
+    expect(queue.depth == 0 && queue.head == NULL, "clear empties the queue");
+
+    if (failures) return 1;
+
+    printf("test=ws_queue game_frames=%d spectator_frames=%d result=ok\n", GAME_FRAMES, SPECTATOR_FRAMES);
+    return 0;
+}
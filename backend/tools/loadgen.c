@@ -0,0 +1,659 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <netdb.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <libwebsockets.h>
+#include <jansson.h>
+
+#include "game.h"
+#include "session.h"
+#include "histogram.h"
+
+/*
+    Plays complete games against a local server. Setup threads create and
+    join sessions over plain HTTP; every game then gets two WebSocket
+    clients on a single lws event loop, which is what lets one process hold
+    tens of thousands of sockets. The round trip of a move is measured from
+    the attack frame being written to the attacker's next message.
+*/
+
+#define DEFAULT_HTTP_PORT 8080
+#define DEFAULT_WS_PORT 9000
+#define DEFAULT_CONCURRENCY 1000
+#define DEFAULT_GAMES 10000
+#define DEFAULT_THINK_MS 100
+#define DEFAULT_DURATION_S 60
+#define DEFAULT_SETUP_THREADS 4
+#define HTTP_RESPONSE_MAX 16384
+#define OUT_MESSAGE_MAX 192
+#define REPORT_INTERVAL_NS 1000000000LL
+#define TICK_US (LWS_US_PER_SEC / 10)
+
+typedef enum {
+    ERROR_HTTP,
+    ERROR_CONNECT,
+    ERROR_CLOSED_EARLY,
+    ERROR_PLAYER_LEFT,
+    ERROR_PROTOCOL,
+    ERROR_COUNT
+} LoadError;
+
+static const char *error_names[ERROR_COUNT] = {
+    "http",
+    "connect",
+    "closed_early",
+    "player_left",
+    "protocol",
+};
+
+typedef struct LoadGame LoadGame;
+
+typedef struct {
+    LoadGame *game;
+    struct lws *wsi;
+    int player_num;
+    int open;
+    int out_is_attack;
+    int attack_pending;
+    int64_t sent_ns;
+    unsigned char out[LWS_PRE + OUT_MESSAGE_MAX];
+    size_t out_len;
+    size_t attack_len;
+    char *rx;
+    size_t rx_len;
+    size_t rx_cap;
+    lws_sorted_usec_list_t think;
+} LoadPlayer;
+
+struct LoadGame {
+    LoadGame *next;
+    char session_id[SESSION_ID_STR_LEN];
+    char tokens[2][PLAYER_TOKEN_STR_LEN];
+    LoadPlayer players[2];
+    int open_players;
+    int finished;
+    int failed;
+};
+
+typedef struct {
+    const char *host;
+    int http_port;
+    int ws_port;
+    int concurrency;
+    long games;
+    int think_ms;
+    int duration_s;
+    int setup_threads;
+    const char *variant;
+} LoadConfig;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    LoadGame *ready;
+    int wanted;
+    int stopping;
+} SetupQueue;
+
+static LoadConfig config = {
+    "127.0.0.1", DEFAULT_HTTP_PORT, DEFAULT_WS_PORT, DEFAULT_CONCURRENCY,
+    DEFAULT_GAMES, DEFAULT_THINK_MS, DEFAULT_DURATION_S, DEFAULT_SETUP_THREADS, "classic"
+};
+
+static SetupQueue setup_queue = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, 0, 0};
+
+static struct lws_context *context;
+static Histogram rtt_histogram;
+static uint64_t moves;
+static uint64_t errors[ERROR_COUNT];
+static long games_started;
+static long games_finished;
+static int games_active;
+static volatile sig_atomic_t interrupted;
+static lws_sorted_usec_list_t tick;
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
+
+/* Blocking HTTP/1.0 POST; returns the parsed JSON body of a 200 reply. */
+static json_t* http_post_json(const char *path, json_t *body) {
+    char *body_str = json_dumps(body, JSON_COMPACT);
+    if (!body_str) return NULL;
+
+    char port_str[16];
+    snprintf(port_str, sizeof(port_str), "%d", config.http_port);
+
+    struct addrinfo hints = {0};
+    struct addrinfo *addr = NULL;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if (getaddrinfo(config.host, port_str, &hints, &addr) != 0) {
+        free(body_str);
+        return NULL;
+    }
+
+    int fd = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+    if (fd < 0 || connect(fd, addr->ai_addr, addr->ai_addrlen) != 0) {
+        if (fd >= 0) close(fd);
+        freeaddrinfo(addr);
+        free(body_str);
+        return NULL;
+    }
+    freeaddrinfo(addr);
+
+    char request[1024];
+    int request_len = snprintf(request, sizeof(request),
+        "POST %s HTTP/1.0\r\nHost: %s\r\nContent-Type: application/json\r\nContent-Length: %zu\r\n\r\n%s",
+        path, config.host, strlen(body_str), body_str);
+    free(body_str);
+
+    if (request_len < 0 || request_len >= (int)sizeof(request) || send(fd, request, request_len, 0) != request_len) {
+        close(fd);
+        return NULL;
+    }
+
+    char response[HTTP_RESPONSE_MAX];
+    size_t response_len = 0;
+    ssize_t n;
+
+    while (response_len < sizeof(response) - 1 &&
+           (n = recv(fd, response + response_len, sizeof(response) - 1 - response_len, 0)) > 0) {
+        response_len += (size_t)n;
+    }
+    close(fd);
+    response[response_len] = '\0';
+
+    char *body_start = strstr(response, "\r\n\r\n");
+    if (strncmp(response, "HTTP/1.", 7) != 0 || strncmp(response + 8, " 200", 4) != 0 || !body_start) {
+        return NULL;
+    }
+
+    return json_loads(body_start + 4, 0, NULL);
+}
+
+static int copy_json_string(json_t *root, const char *key, char *out, size_t out_size) {
+    const char *value = json_string_value(json_object_get(root, key));
+    if (!value || strlen(value) >= out_size) return 0;
+
+    strcpy(out, value);
+    return 1;
+}
+
+static LoadGame* create_load_game(void) {
+    LoadGame *game = calloc(1, sizeof(LoadGame));
+    if (!game) return NULL;
+
+    json_t *create = json_pack("{s:s, s:s}", "player_name", "load1", "variant", config.variant);
+    json_t *created = http_post_json("/create", create);
+    json_decref(create);
+
+    if (!created ||
+        !copy_json_string(created, "session_id", game->session_id, sizeof(game->session_id)) ||
+        !copy_json_string(created, "token", game->tokens[0], sizeof(game->tokens[0]))) {
+        json_decref(created);
+        free(game);
+        return NULL;
+    }
+    json_decref(created);
+
+    json_t *join = json_pack("{s:s, s:s}", "session_id", game->session_id, "player_name", "load2");
+    json_t *joined = http_post_json("/join", join);
+    json_decref(join);
+
+    if (!joined || !copy_json_string(joined, "token", game->tokens[1], sizeof(game->tokens[1]))) {
+        json_decref(joined);
+        free(game);
+        return NULL;
+    }
+    json_decref(joined);
+
+    return game;
+}
+
+static void* setup_main(void *arg) {
+    (void)arg;
+
+    for (;;) {
+        pthread_mutex_lock(&setup_queue.mutex);
+        while (!setup_queue.wanted && !setup_queue.stopping) {
+            pthread_cond_wait(&setup_queue.cond, &setup_queue.mutex);
+        }
+        if (setup_queue.stopping) {
+            pthread_mutex_unlock(&setup_queue.mutex);
+            return NULL;
+        }
+        setup_queue.wanted--;
+        pthread_mutex_unlock(&setup_queue.mutex);
+
+        LoadGame *game = create_load_game();
+
+        pthread_mutex_lock(&setup_queue.mutex);
+        if (game) {
+            game->next = setup_queue.ready;
+            setup_queue.ready = game;
+        } else {
+            // Ask for a replacement; the failure is counted by the loop.
+            LoadGame *failed = calloc(1, sizeof(LoadGame));
+            if (failed) {
+                failed->failed = 1;
+                failed->next = setup_queue.ready;
+                setup_queue.ready = failed;
+            }
+        }
+        pthread_mutex_unlock(&setup_queue.mutex);
+
+        lws_cancel_service(context);
+    }
+}
+
+
+
+static void on_think_done(lws_sorted_usec_list_t *sul) {
+    LoadPlayer *player = lws_container_of(sul, LoadPlayer, think);
+    if (!player->wsi || player->game->finished) return;
+
+    player->out_len = player->attack_len;
+    player->out_is_attack = 1;
+    lws_callback_on_writable(player->wsi);
+}
+
+static void finish_game(LoadGame *game, int failed) {
+    if (game->finished) return;
+
+    game->finished = 1;
+    game->failed = failed;
+    if (!failed) games_finished++;
+
+    for (int i = 0; i < 2; i++) {
+        if (game->players[i].wsi) {
+            lws_set_timeout(game->players[i].wsi, PENDING_TIMEOUT_CLOSE_SEND, LWS_TO_KILL_ASYNC);
+        }
+    }
+}
+
+// Picks a random cell the player has not fired at yet, from its own view.
+static int choose_attack(json_t *state, int *x, int *y) {
+    json_t *cells = json_object_get(json_object_get(state, "enemy_board"), "cells");
+    int n = (int)json_array_size(cells);
+    int candidates = 0;
+
+    for (int row = 0; row < n; row++) {
+        json_t *cells_row = json_array_get(cells, row);
+        for (int col = 0; col < n; col++) {
+            int cell = (int)json_integer_value(json_array_get(cells_row, col));
+            if (cell == EMPTY || cell == SHIP) candidates++;
+        }
+    }
+    if (candidates == 0) return 0;
+
+    int pick = (int)(game_random() % (uint32_t)candidates);
+    for (int row = 0; row < n; row++) {
+        json_t *cells_row = json_array_get(cells, row);
+        for (int col = 0; col < n; col++) {
+            int cell = (int)json_integer_value(json_array_get(cells_row, col));
+            if ((cell == EMPTY || cell == SHIP) && pick-- == 0) {
+                *x = col;
+                *y = row;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void handle_message(LoadPlayer *player, const char *message, size_t len) {
+    LoadGame *game = player->game;
+
+    if (player->attack_pending) {
+        player->attack_pending = 0;
+        histogram_record(&rtt_histogram, (uint64_t)(now_ns() - player->sent_ns));
+        moves++;
+    }
+
+    json_t *root = json_loadb(message, len, 0, NULL);
+    const char *type = json_string_value(json_object_get(root, "type"));
+
+    if (!type) {
+        errors[ERROR_PROTOCOL]++;
+    } else if (strcmp(type, "game_state") == 0) {
+        int current = (int)json_integer_value(json_object_get(root, "current_player"));
+        int x, y;
+
+        if (current == player->player_num && choose_attack(root, &x, &y)) {
+            player->attack_len = (size_t)snprintf((char *)&player->out[LWS_PRE], OUT_MESSAGE_MAX,
+                "{\"type\":\"attack\",\"x\":%d,\"y\":%d}", x, y);
+            lws_sul_schedule(context, 0, &player->think, on_think_done, (int64_t)config.think_ms * LWS_US_PER_MS);
+        }
+    } else if (strcmp(type, "attack_result") == 0) {
+        if (json_is_true(json_object_get(root, "game_over"))) {
+            finish_game(game, 0);
+        }
+    } else if (strcmp(type, "player_left") == 0) {
+        if (!game->finished) {
+            errors[ERROR_PLAYER_LEFT]++;
+            finish_game(game, 1);
+        }
+    }
+
+    json_decref(root);
+}
+
+// A game lives while either of its sockets is open.
+static void release_game(LoadGame *game) {
+    if (--game->open_players == 0) {
+        games_active--;
+        free(game);
+    }
+}
+
+static void release_player(LoadPlayer *player) {
+    if (!player->open) return;
+
+    lws_sul_cancel(&player->think);
+    free(player->rx);
+    player->rx = NULL;
+    player->wsi = NULL;
+    player->open = 0;
+
+    release_game(player->game);
+}
+
+static int callback_load(struct lws *wsi, enum lws_callback_reasons reason, void *user, void *in, size_t len) {
+    LoadPlayer *player = (LoadPlayer *)user;
+
+    switch (reason) {
+        case LWS_CALLBACK_CLIENT_ESTABLISHED:
+            player->out_len = (size_t)snprintf((char *)&player->out[LWS_PRE], OUT_MESSAGE_MAX,
+                "{\"type\":\"join\",\"session_id\":\"%s\",\"token\":\"%s\"}",
+                player->game->session_id, player->game->tokens[player->player_num - 1]);
+            player->out_is_attack = 0;
+            lws_callback_on_writable(wsi);
+            break;
+
+        case LWS_CALLBACK_CLIENT_WRITEABLE:
+            if (player->out_len) {
+                if (lws_write(wsi, &player->out[LWS_PRE], player->out_len, LWS_WRITE_TEXT) < (int)player->out_len) {
+                    return -1;
+                }
+
+                if (player->out_is_attack) {
+                    player->attack_pending = 1;
+                    player->sent_ns = now_ns();
+                }
+                player->out_len = 0;
+            }
+            break;
+
+        case LWS_CALLBACK_CLIENT_RECEIVE:
+            if (player->rx_len + len > player->rx_cap) {
+                size_t cap = player->rx_cap ? player->rx_cap : 4096;
+                while (cap < player->rx_len + len) cap *= 2;
+
+                char *rx = realloc(player->rx, cap);
+                if (!rx) return -1;
+                player->rx = rx;
+                player->rx_cap = cap;
+            }
+            memcpy(player->rx + player->rx_len, in, len);
+            player->rx_len += len;
+
+            if (lws_is_final_fragment(wsi) && !lws_remaining_packet_payload(wsi)) {
+                handle_message(player, player->rx, player->rx_len);
+                player->rx_len = 0;
+            }
+            break;
+
+        case LWS_CALLBACK_CLIENT_CONNECTION_ERROR:
+            if (player && !player->game->finished) {
+                errors[ERROR_CONNECT]++;
+                finish_game(player->game, 1);
+            }
+            break;
+
+        case LWS_CALLBACK_CLIENT_CLOSED:
+            if (player && !player->game->finished) {
+                errors[ERROR_CLOSED_EARLY]++;
+                finish_game(player->game, 1);
+            }
+            break;
+
+        case LWS_CALLBACK_WSI_DESTROY:
+            if (player) {
+                release_player(player);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+static struct lws_protocols load_protocols[] = {
+    { "battleship-protocol", callback_load, 0, 4096, 0, NULL, 0 },
+    { NULL, NULL, 0, 0, 0, NULL, 0 }
+};
+
+static void connect_game(LoadGame *game) {
+    games_active++;
+    games_started++;
+
+    // Held until both connects are issued; a failing connect may release
+    // its player from inside lws_client_connect_via_info().
+    game->open_players = 1;
+
+    for (int i = 0; i < 2; i++) {
+        LoadPlayer *player = &game->players[i];
+        player->game = game;
+        player->player_num = i + 1;
+
+        struct lws_client_connect_info info;
+        memset(&info, 0, sizeof(info));
+        info.context = context;
+        info.address = config.host;
+        info.port = config.ws_port;
+        info.path = "/";
+        info.host = config.host;
+        info.origin = config.host;
+        info.protocol = load_protocols[0].name;
+        info.userdata = player;
+
+        player->open = 1;
+        game->open_players++;
+
+        struct lws *wsi = lws_client_connect_via_info(&info);
+        if (player->open) {
+            player->wsi = wsi;
+        }
+        if (!wsi) {
+            if (!game->finished) errors[ERROR_CONNECT]++;
+            finish_game(game, 1);
+            release_player(player);
+        }
+    }
+
+    release_game(game);
+}
+
+static int take_ready_games(void) {
+    int taken = 0;
+
+    pthread_mutex_lock(&setup_queue.mutex);
+    LoadGame *ready = setup_queue.ready;
+    setup_queue.ready = NULL;
+    pthread_mutex_unlock(&setup_queue.mutex);
+
+    while (ready) {
+        LoadGame *next = ready->next;
+        taken++;
+
+        if (ready->failed) {
+            errors[ERROR_HTTP]++;
+            games_started++;
+            free(ready);
+        } else {
+            connect_game(ready);
+        }
+
+        ready = next;
+    }
+
+    return taken;
+}
+
+static void request_games(int *requested) {
+    int free_slots = config.concurrency - games_active - *requested;
+    long remaining = config.games - games_started - *requested;
+    int count = free_slots < remaining ? free_slots : (int)remaining;
+
+    if (count <= 0) return;
+
+    pthread_mutex_lock(&setup_queue.mutex);
+    setup_queue.wanted += count;
+    pthread_cond_broadcast(&setup_queue.cond);
+    pthread_mutex_unlock(&setup_queue.mutex);
+
+    *requested += count;
+}
+
+
+
+static void raise_fd_limit(void) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+// Wakes lws_service() regularly so the loop can report and stop on time.
+static void on_tick(lws_sorted_usec_list_t *sul) {
+    lws_sul_schedule(context, 0, sul, on_tick, TICK_US);
+}
+
+static void on_signal(int sig) {
+    (void)sig;
+    interrupted = 1;
+}
+
+static void print_usage(const char *name) {
+    fprintf(stderr,
+        "usage: %s [-H host] [-p http_port] [-w ws_port] [-c concurrent_games] [-n games]\n"
+        "          [-t think_ms] [-d duration_s] [-j setup_threads] [-v variant]\n", name);
+}
+
+static void print_report(const char *label, double elapsed, uint64_t moves_in_window, double window) {
+    printf("%s elapsed_s=%.1f games_active=%d games_finished=%ld moves=%llu moves_per_sec=%.0f "
+        "rtt_p50_us=%.1f rtt_p99_us=%.1f rtt_p999_us=%.1f",
+        label, elapsed, games_active, games_finished, (unsigned long long)moves, moves_in_window / window,
+        histogram_percentile(&rtt_histogram, 0.50) / 1e3, histogram_percentile(&rtt_histogram, 0.99) / 1e3,
+        histogram_percentile(&rtt_histogram, 0.999) / 1e3);
+
+    for (int i = 0; i < ERROR_COUNT; i++) {
+        printf(" errors_%s=%llu", error_names[i], (unsigned long long)errors[i]);
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "H:p:w:c:n:t:d:j:v:")) != -1) {
+        switch (opt) {
+            case 'H': config.host = optarg; break;
+            case 'p': config.http_port = atoi(optarg); break;
+            case 'w': config.ws_port = atoi(optarg); break;
+            case 'c': config.concurrency = atoi(optarg); break;
+            case 'n': config.games = atol(optarg); break;
+            case 't': config.think_ms = atoi(optarg); break;
+            case 'd': config.duration_s = atoi(optarg); break;
+            case 'j': config.setup_threads = atoi(optarg); break;
+            case 'v': config.variant = optarg; break;
+            default: print_usage(argv[0]); return 1;
+        }
+    }
+
+    if (config.concurrency < 1 || config.games < 1 || config.think_ms < 0 ||
+        config.duration_s < 1 || config.setup_threads < 1 || find_game_variant(config.variant) < 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    raise_fd_limit();
+    signal(SIGINT, on_signal);
+    signal(SIGPIPE, SIG_IGN);
+    lws_set_log_level(LLL_ERR, NULL);
+    histogram_init(&rtt_histogram);
+
+    struct lws_context_creation_info info;
+    memset(&info, 0, sizeof(info));
+    info.port = CONTEXT_PORT_NO_LISTEN;
+    info.protocols = load_protocols;
+    info.gid = -1;
+    info.uid = -1;
+
+    context = lws_create_context(&info);
+    if (!context) {
+        fprintf(stderr, "Failed to create WebSocket context\n");
+        return 1;
+    }
+
+    lws_sul_schedule(context, 0, &tick, on_tick, TICK_US);
+
+    pthread_t setup_threads[config.setup_threads];
+    for (int i = 0; i < config.setup_threads; i++) {
+        pthread_create(&setup_threads[i], NULL, setup_main, NULL);
+    }
+
+    int64_t start = now_ns();
+    int64_t deadline = start + (int64_t)config.duration_s * 1000000000;
+    int64_t last_report = start;
+    uint64_t last_moves = 0;
+    int requested = 0;
+
+    while (!interrupted && now_ns() < deadline) {
+        requested -= take_ready_games();
+        request_games(&requested);
+
+        if (games_started >= config.games && games_active == 0) break;
+
+        lws_service(context, 0);
+
+        int64_t now = now_ns();
+        if (now - last_report >= REPORT_INTERVAL_NS) {
+            print_report("progress", (now - start) / 1e9, moves - last_moves, (now - last_report) / 1e9);
+            last_report = now;
+            last_moves = moves;
+        }
+    }
+
+    double elapsed = (now_ns() - start) / 1e9;
+    print_report("total", elapsed, moves, elapsed);
+
+    pthread_mutex_lock(&setup_queue.mutex);
+    setup_queue.stopping = 1;
+    pthread_cond_broadcast(&setup_queue.cond);
+    pthread_mutex_unlock(&setup_queue.mutex);
+
+    for (int i = 0; i < config.setup_threads; i++) {
+        pthread_join(setup_threads[i], NULL);
+    }
+
+    lws_context_destroy(context);
+    return 0;
+}
@@ -0,0 +1,536 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <jansson.h>
+
+#include "game.h"
+#include "session.h"
+#include "histogram.h"
+
+/*
+    Closed-loop lobby traffic: every client thread picks an endpoint from
+    the configured mix, sends it, waits for the full reply and records the
+    latency. With keep-alive on, a thread reuses one HTTP/1.1 connection
+    until the server closes it; with it off, every request connects anew.
+    Run it against each server -m mode to compare them.
+*/
+
+#define DEFAULT_HTTP_PORT 8080
+#define DEFAULT_CLIENTS 16
+#define DEFAULT_DURATION_S 10
+#define MAX_CLIENTS 1024
+#define RESPONSE_LINE_MAX 1024
+#define JOIN_BACKLOG 64
+
+typedef enum {
+    ENDPOINT_SESSIONS,
+    ENDPOINT_CREATE,
+    ENDPOINT_JOIN,
+    ENDPOINT_COUNT
+} Endpoint;
+
+static const char *endpoint_names[ENDPOINT_COUNT] = {
+    "sessions",
+    "create",
+    "join",
+};
+
+typedef struct {
+    const char *host;
+    int port;
+    int clients;
+    int duration_s;
+    int keep_alive;
+    int weights[ENDPOINT_COUNT];
+    const char *variant;
+} LobbyConfig;
+
+typedef struct {
+    uint64_t requests;
+    uint64_t bytes;
+    uint64_t status_errors;
+    uint64_t io_errors;
+    Histogram latency;
+} EndpointStats;
+
+typedef struct {
+    int fd;
+    uint64_t rng;
+    uint64_t connects;
+    char join_ids[JOIN_BACKLOG][SESSION_ID_STR_LEN];
+    int join_count;
+    char rbuf[16384];
+    size_t rpos;
+    size_t rlen;
+    char *body;
+    size_t body_cap;
+    EndpointStats stats[ENDPOINT_COUNT];
+} LobbyClient;
+
+static LobbyConfig config = {
+    "127.0.0.1", DEFAULT_HTTP_PORT, DEFAULT_CLIENTS, DEFAULT_DURATION_S, 1, {90, 8, 2}, "classic"
+};
+
+static struct addrinfo *server_addr;
+static volatile sig_atomic_t stopping;
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static inline uint32_t next_random(LobbyClient *client) {
+    client->rng ^= client->rng << 13;
+    client->rng ^= client->rng >> 7;
+    client->rng ^= client->rng << 17;
+    return (uint32_t)(client->rng >> 32);
+}
+
+
+
+static int open_connection(LobbyClient *client) {
+    int fd = socket(server_addr->ai_family, server_addr->ai_socktype, server_addr->ai_protocol);
+    if (fd < 0) return -1;
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    if (connect(fd, server_addr->ai_addr, server_addr->ai_addrlen) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    client->connects++;
+    return fd;
+}
+
+static void close_connection(LobbyClient *client) {
+    if (client->fd >= 0) {
+        close(client->fd);
+        client->fd = -1;
+    }
+    client->rpos = client->rlen = 0;
+}
+
+static int send_all(int fd, const char *data, size_t len) {
+    while (len) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n <= 0) return 0;
+        data += n;
+        len -= (size_t)n;
+    }
+    return 1;
+}
+
+static int body_reserve(LobbyClient *client, size_t size) {
+    if (size + 1 <= client->body_cap) return 1;
+
+    size_t cap = client->body_cap ? client->body_cap : 4096;
+    while (cap < size + 1) cap *= 2;
+
+    char *body = realloc(client->body, cap);
+    if (!body) return 0;
+
+    client->body = body;
+    client->body_cap = cap;
+    return 1;
+}
+
+static int fill_buffer(LobbyClient *client) {
+    if (client->rpos == client->rlen) {
+        client->rpos = client->rlen = 0;
+    }
+    if (client->rlen == sizeof(client->rbuf)) {
+        memmove(client->rbuf, client->rbuf + client->rpos, client->rlen - client->rpos);
+        client->rlen -= client->rpos;
+        client->rpos = 0;
+    }
+
+    ssize_t n = recv(client->fd, client->rbuf + client->rlen, sizeof(client->rbuf) - client->rlen, 0);
+    if (n <= 0) return (int)n;
+
+    client->rlen += (size_t)n;
+    return 1;
+}
+
+/* Reads one CRLF-terminated line into out, without the CRLF. */
+static int read_line(LobbyClient *client, char *out, size_t out_size) {
+    for (;;) {
+        char *start = client->rbuf + client->rpos;
+        char *end = memchr(start, '\n', client->rlen - client->rpos);
+
+        if (end) {
+            size_t len = (size_t)(end - start);
+            if (len && start[len - 1] == '\r') len--;
+            if (len >= out_size) return 0;
+
+            memcpy(out, start, len);
+            out[len] = '\0';
+            client->rpos += (size_t)(end - start) + 1;
+            return 1;
+        }
+
+        if (client->rlen - client->rpos == sizeof(client->rbuf) || fill_buffer(client) <= 0) {
+            return 0;
+        }
+    }
+}
+
+/* Appends up to len body bytes; with until_eof, stops quietly at EOF. */
+static int read_body(LobbyClient *client, size_t *body_len, size_t len, int until_eof) {
+    while (len) {
+        if (client->rpos == client->rlen) {
+            int n = fill_buffer(client);
+            if (n == 0 && until_eof) return 1;
+            if (n <= 0) return 0;
+        }
+
+        size_t take = client->rlen - client->rpos;
+        if (take > len) take = len;
+        if (!body_reserve(client, *body_len + take)) return 0;
+
+        memcpy(client->body + *body_len, client->rbuf + client->rpos, take);
+        *body_len += take;
+        client->rpos += take;
+        len -= take;
+    }
+    return 1;
+}
+
+/*
+    Reads one response: the head, then a Content-Length or chunked body,
+    or everything up to EOF. Leaves the body in client->body and returns
+    the status code, or -1 if the connection broke.
+*/
+static int read_response(LobbyClient *client, size_t *body_len, int *server_closes) {
+    char line[RESPONSE_LINE_MAX];
+    int status = 0;
+    int minor = 0;
+
+    if (!read_line(client, line, sizeof(line)) || sscanf(line, "HTTP/1.%d %d", &minor, &status) != 2) {
+        return -1;
+    }
+
+    long content_length = -1;
+    int chunked = 0;
+    *server_closes = (minor == 0);
+
+    for (;;) {
+        if (!read_line(client, line, sizeof(line))) return -1;
+        if (line[0] == '\0') break;
+
+        char *value = strchr(line, ':');
+        if (!value) continue;
+        value += 1 + strspn(value + 1, " ");
+
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            content_length = atol(value);
+        } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+            chunked = strstr(value, "chunked") != NULL;
+        } else if (strncasecmp(line, "Connection:", 11) == 0) {
+            *server_closes = strncasecmp(value, "close", 5) == 0;
+        }
+    }
+
+    *body_len = 0;
+
+    if (chunked) {
+        for (;;) {
+            if (!read_line(client, line, sizeof(line))) return -1;
+
+            size_t chunk = strtoul(line, NULL, 16);
+            if (chunk == 0) {
+                // Trailers end with an empty line.
+                do {
+                    if (!read_line(client, line, sizeof(line))) return -1;
+                } while (line[0] != '\0');
+                break;
+            }
+
+            if (!read_body(client, body_len, chunk, 0) || !read_line(client, line, sizeof(line))) return -1;
+        }
+    } else if (content_length >= 0) {
+        if (!read_body(client, body_len, (size_t)content_length, 0)) return -1;
+    } else {
+        if (!read_body(client, body_len, SIZE_MAX, 1)) return -1;
+        *server_closes = 1;
+    }
+
+    if (!body_reserve(client, *body_len)) return -1;
+    client->body[*body_len] = '\0';
+    return status;
+}
+
+static void remember_session(LobbyClient *client, const char *body) {
+    json_t *root = json_loads(body, 0, NULL);
+    const char *session_id = json_string_value(json_object_get(root, "session_id"));
+
+    if (session_id && strlen(session_id) < SESSION_ID_STR_LEN) {
+        int slot = client->join_count < JOIN_BACKLOG ? client->join_count++ : (int)(next_random(client) % JOIN_BACKLOG);
+        strcpy(client->join_ids[slot], session_id);
+    }
+
+    json_decref(root);
+}
+
+static Endpoint pick_endpoint(LobbyClient *client) {
+    int total = config.weights[ENDPOINT_SESSIONS] + config.weights[ENDPOINT_CREATE] + config.weights[ENDPOINT_JOIN];
+    int pick = (int)(next_random(client) % (uint32_t)total);
+
+    for (int i = 0; i < ENDPOINT_COUNT; i++) {
+        if (pick < config.weights[i]) {
+            // Nothing to join yet: create a session instead.
+            if (i == ENDPOINT_JOIN && client->join_count == 0) return ENDPOINT_CREATE;
+            return (Endpoint)i;
+        }
+        pick -= config.weights[i];
+    }
+
+    return ENDPOINT_SESSIONS;
+}
+
+static int build_request(LobbyClient *client, Endpoint endpoint, char *out, size_t out_size) {
+    const char *connection = config.keep_alive ? "keep-alive" : "close";
+    char body[256];
+
+    switch (endpoint) {
+        case ENDPOINT_SESSIONS:
+            return snprintf(out, out_size, "GET /sessions HTTP/1.1\r\nHost: %s\r\nConnection: %s\r\n\r\n",
+                config.host, connection);
+
+        case ENDPOINT_CREATE:
+            snprintf(body, sizeof(body), "{\"player_name\":\"lobby\",\"variant\":\"%s\"}", config.variant);
+            break;
+
+        case ENDPOINT_JOIN: {
+            int slot = --client->join_count;
+            snprintf(body, sizeof(body), "{\"session_id\":\"%s\",\"player_name\":\"lobby\"}", client->join_ids[slot]);
+            break;
+        }
+
+        default:
+            return -1;
+    }
+
+    return snprintf(out, out_size,
+        "POST /%s HTTP/1.1\r\nHost: %s\r\nConnection: %s\r\nContent-Type: application/json\r\nContent-Length: %zu\r\n\r\n%s",
+        endpoint_names[endpoint], config.host, connection, strlen(body), body);
+}
+
+static void* client_main(void *arg) {
+    LobbyClient *client = arg;
+    char request[1024];
+
+    while (!stopping) {
+        Endpoint endpoint = pick_endpoint(client);
+        EndpointStats *stats = &client->stats[endpoint];
+
+        int request_len = build_request(client, endpoint, request, sizeof(request));
+        int64_t start = now_ns();
+
+        if (client->fd < 0) {
+            client->fd = open_connection(client);
+        }
+
+        size_t body_len = 0;
+        int server_closes = 1;
+        int status = -1;
+
+        if (client->fd >= 0 && send_all(client->fd, request, (size_t)request_len)) {
+            status = read_response(client, &body_len, &server_closes);
+        }
+
+        if (status < 0) {
+            stats->io_errors++;
+            close_connection(client);
+            continue;
+        }
+
+        histogram_record(&stats->latency, (uint64_t)(now_ns() - start));
+        stats->requests++;
+        stats->bytes += body_len;
+
+        if (status != 200) {
+            stats->status_errors++;
+        } else if (endpoint == ENDPOINT_CREATE) {
+            remember_session(client, client->body);
+        }
+
+        if (server_closes || !config.keep_alive) {
+            close_connection(client);
+        }
+    }
+
+    close_connection(client);
+    return NULL;
+}
+
+
+
+static int parse_mix(const char *mix) {
+    int weights[ENDPOINT_COUNT] = {0};
+    char *copy = strdup(mix);
+    if (!copy) return 0;
+
+    for (char *save = NULL, *item = strtok_r(copy, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+        char *eq = strchr(item, '=');
+        if (!eq) {
+            free(copy);
+            return 0;
+        }
+        *eq = '\0';
+
+        int found = 0;
+        for (int i = 0; i < ENDPOINT_COUNT; i++) {
+            if (strcmp(item, endpoint_names[i]) == 0) {
+                weights[i] = atoi(eq + 1);
+                found = 1;
+            }
+        }
+        if (!found || weights[0] < 0 || weights[1] < 0 || weights[2] < 0) {
+            free(copy);
+            return 0;
+        }
+    }
+    free(copy);
+
+    if (weights[ENDPOINT_SESSIONS] + weights[ENDPOINT_CREATE] + weights[ENDPOINT_JOIN] <= 0) return 0;
+
+    memcpy(config.weights, weights, sizeof(weights));
+    return 1;
+}
+
+static void on_signal(int sig) {
+    (void)sig;
+    stopping = 1;
+}
+
+static void print_usage(const char *name) {
+    fprintf(stderr,
+        "usage: %s [-H host] [-p port] [-c clients <= %d] [-d duration_s] [-k 0|1]\n"
+        "          [-m sessions=90,create=8,join=2] [-v variant]\n", name, MAX_CLIENTS);
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "H:p:c:d:k:m:v:")) != -1) {
+        switch (opt) {
+            case 'H': config.host = optarg; break;
+            case 'p': config.port = atoi(optarg); break;
+            case 'c': config.clients = atoi(optarg); break;
+            case 'd': config.duration_s = atoi(optarg); break;
+            case 'k': config.keep_alive = atoi(optarg) != 0; break;
+            case 'm':
+                if (!parse_mix(optarg)) {
+                    print_usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'v': config.variant = optarg; break;
+            default: print_usage(argv[0]); return 1;
+        }
+    }
+
+    if (config.clients < 1 || config.clients > MAX_CLIENTS || config.duration_s < 1 || find_game_variant(config.variant) < 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    char port_str[16];
+    snprintf(port_str, sizeof(port_str), "%d", config.port);
+
+    struct addrinfo hints = {0};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(config.host, port_str, &hints, &server_addr) != 0) {
+        fprintf(stderr, "cannot resolve %s\n", config.host);
+        return 1;
+    }
+
+    signal(SIGINT, on_signal);
+
+    LobbyClient *clients = calloc((size_t)config.clients, sizeof(LobbyClient));
+    pthread_t *threads = calloc((size_t)config.clients, sizeof(pthread_t));
+    if (!clients || !threads) {
+        fprintf(stderr, "cannot allocate %d clients\n", config.clients);
+        return 1;
+    }
+
+    int64_t start = now_ns();
+
+    for (int i = 0; i < config.clients; i++) {
+        clients[i].fd = -1;
+        clients[i].rng = 0x9e3779b97f4a7c15ull * (uint64_t)(i + 1);
+        for (int e = 0; e < ENDPOINT_COUNT; e++) {
+            histogram_init(&clients[i].stats[e].latency);
+        }
+        pthread_create(&threads[i], NULL, client_main, &clients[i]);
+    }
+
+    struct timespec tick = {0, 100000000};
+    for (int s = 0; s < config.duration_s * 10 && !stopping; s++) {
+        nanosleep(&tick, NULL);
+    }
+    stopping = 1;
+
+    uint64_t connects = 0;
+    for (int i = 0; i < config.clients; i++) {
+        pthread_join(threads[i], NULL);
+        connects += clients[i].connects;
+    }
+
+    double elapsed = (now_ns() - start) / 1e9;
+    uint64_t total_requests = 0;
+
+    printf("clients=%d keep_alive=%d mix=sessions:%d,create:%d,join:%d elapsed_s=%.2f connects=%llu\n",
+        config.clients, config.keep_alive, config.weights[ENDPOINT_SESSIONS], config.weights[ENDPOINT_CREATE],
+        config.weights[ENDPOINT_JOIN], elapsed, (unsigned long long)connects);
+
+    for (int e = 0; e < ENDPOINT_COUNT; e++) {
+        EndpointStats total;
+        memset(&total, 0, sizeof(total));
+        histogram_init(&total.latency);
+
+        for (int i = 0; i < config.clients; i++) {
+            total.requests += clients[i].stats[e].requests;
+            total.bytes += clients[i].stats[e].bytes;
+            total.status_errors += clients[i].stats[e].status_errors;
+            total.io_errors += clients[i].stats[e].io_errors;
+            histogram_merge(&total.latency, &clients[i].stats[e].latency);
+        }
+        total_requests += total.requests;
+
+        if (!total.requests && !total.io_errors) continue;
+
+        printf("endpoint=%s requests=%llu req_per_sec=%.0f avg_body_bytes=%.0f status_errors=%llu io_errors=%llu "
+            "p50_us=%.1f p90_us=%.1f p99_us=%.1f p999_us=%.1f max_us=%.1f\n",
+            endpoint_names[e], (unsigned long long)total.requests, total.requests / elapsed,
+            total.requests ? (double)total.bytes / total.requests : 0.0,
+            (unsigned long long)total.status_errors, (unsigned long long)total.io_errors,
+            histogram_percentile(&total.latency, 0.50) / 1e3, histogram_percentile(&total.latency, 0.90) / 1e3,
+            histogram_percentile(&total.latency, 0.99) / 1e3, histogram_percentile(&total.latency, 0.999) / 1e3,
+            total.latency.max / 1e3);
+    }
+
+    printf("total requests=%llu req_per_sec=%.0f\n", (unsigned long long)total_requests, total_requests / elapsed);
+
+    for (int i = 0; i < config.clients; i++) {
+        free(clients[i].body);
+    }
+    free(clients);
+    free(threads);
+    freeaddrinfo(server_addr);
+    return 0;
+}
@@ -0,0 +1,266 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "game.h"
+#include "session.h"
+#include "bot.h"
+
+#define DEFAULT_GAMES 1000000
+#define MAX_THREADS 256
+#define MAX_GAME_SHOTS (2 * MAX_BOARD_SIZE * MAX_BOARD_SIZE)
+#define PROFILE_GAMES 20000
+#define TIMER_CALIBRATION_ROUNDS 100000
+
+/*
+    Headless bot-vs-bot games. The first pass plays the requested number of
+    games on every core and only counts; the second pass plays a smaller
+    batch on one thread with a timer around every kernel call.
+*/
+
+typedef struct {
+    int variant;
+    long games;
+    uint64_t seed;
+    uint64_t shots;
+    long histogram[MAX_GAME_SHOTS + 1];
+} SimulationWorker;
+
+typedef enum {
+    KERNEL_SETUP_RANDOM_BOARD,
+    KERNEL_BOT_CHOOSE_SHOT,
+    KERNEL_CHECK_HIT,
+    KERNEL_IS_SHIP_SUNK,
+    KERNEL_SUNK_THE_SHIP,
+    KERNEL_IS_GAME_OVER,
+    KERNEL_COUNT
+} KernelId;
+
+static const char *kernel_names[KERNEL_COUNT] = {
+    "setup_random_board",
+    "bot_choose_shot",
+    "check_hit",
+    "is_ship_sunk",
+    "sunk_the_ship",
+    "is_game_over",
+};
+
+typedef struct {
+    uint64_t calls;
+    int64_t total_ns;
+} KernelTiming;
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void start_game(GameSession *session, const GameVariant *variant) {
+    setup_random_board(&session->board1, variant);
+    setup_random_board(&session->board2, variant);
+    session->state = IN_PROGRESS;
+    session->current_player = 1;
+}
+
+static int play_game(GameSession *session) {
+    int shots = 0;
+
+    while (session->state == IN_PROGRESS) {
+        Board *target = (session->current_player == 1) ? &session->board2 : &session->board1;
+        int x, y;
+
+        if (!bot_choose_shot(target, &x, &y)) break;
+
+        shots++;
+        apply_attack(session, x, y);
+    }
+
+    return shots;
+}
+
+static void* run_worker(void *arg) {
+    SimulationWorker *worker = arg;
+    const GameVariant *variant = &game_variants[worker->variant];
+    GameSession session;
+
+    memset(&session, 0, sizeof(session));
+    game_seed_random(worker->seed);
+
+    for (long i = 0; i < worker->games; i++) {
+        start_game(&session, variant);
+        int shots = play_game(&session);
+
+        worker->shots += shots;
+        worker->histogram[shots]++;
+    }
+
+    return NULL;
+}
+
+static long histogram_percentile(const long *histogram, long total, double fraction) {
+    long rank = (long)(fraction * (total - 1));
+    long seen = 0;
+
+    for (int shots = 0; shots <= MAX_GAME_SHOTS; shots++) {
+        seen += histogram[shots];
+        if (seen > rank) return shots;
+    }
+    return MAX_GAME_SHOTS;
+}
+
+static void print_distribution(const long *histogram, long games) {
+    int min = -1, max = 0;
+    for (int shots = 0; shots <= MAX_GAME_SHOTS; shots++) {
+        if (!histogram[shots]) continue;
+        if (min < 0) min = shots;
+        max = shots;
+    }
+
+    printf("shots_per_game min=%d p10=%ld p50=%ld p90=%ld p99=%ld max=%d\n",
+        min, histogram_percentile(histogram, games, 0.10), histogram_percentile(histogram, games, 0.50),
+        histogram_percentile(histogram, games, 0.90), histogram_percentile(histogram, games, 0.99), max);
+
+    // Buckets of 4 shots keep the chart short enough to read in a terminal.
+    long buckets[MAX_GAME_SHOTS / 4 + 1] = {0};
+    long peak = 1;
+    for (int shots = min; shots <= max; shots++) {
+        buckets[shots / 4] += histogram[shots];
+        if (buckets[shots / 4] > peak) peak = buckets[shots / 4];
+    }
+
+    for (int bucket = min / 4; bucket <= max / 4; bucket++) {
+        long count = buckets[bucket];
+        int start = bucket * 4;
+
+        char bar[51];
+        int width = (int)(50 * count / peak);
+        memset(bar, '#', width);
+        bar[width] = '\0';
+
+        printf("  %3d-%-3d %9ld %s\n", start, start + 3, count, bar);
+    }
+}
+
+static int run_throughput(int variant, long games, int threads) {
+    static SimulationWorker workers[MAX_THREADS];
+    pthread_t thread_ids[MAX_THREADS];
+
+    for (int i = 0; i < threads; i++) {
+        memset(&workers[i], 0, sizeof(SimulationWorker));
+        workers[i].variant = variant;
+        workers[i].games = games / threads + (i < games % threads ? 1 : 0);
+        workers[i].seed = 0x9e3779b97f4a7c15ull * (uint64_t)(i + 1);
+    }
+
+    int64_t start = now_ns();
+
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&thread_ids[i], NULL, run_worker, &workers[i]) != 0) {
+            fprintf(stderr, "cannot start worker %d\n", i);
+            return 1;
+        }
+    }
+
+    static long histogram[MAX_GAME_SHOTS + 1];
+    uint64_t shots = 0;
+
+    for (int i = 0; i < threads; i++) {
+        pthread_join(thread_ids[i], NULL);
+
+        shots += workers[i].shots;
+        for (int j = 0; j <= MAX_GAME_SHOTS; j++) {
+            histogram[j] += workers[i].histogram[j];
+        }
+    }
+
+    double elapsed = (now_ns() - start) / 1e9;
+
+    printf("variant=%s games=%ld threads=%d elapsed_s=%.3f games_per_sec=%.0f shots_per_sec=%.0f avg_shots=%.2f\n",
+        game_variants[variant].name, games, threads, elapsed, games / elapsed, shots / elapsed, (double)shots / games);
+    print_distribution(histogram, games);
+
+    return 0;
+}
+
+static int64_t timer_overhead_ns(void) {
+    int64_t start = now_ns();
+    for (int i = 0; i < TIMER_CALIBRATION_ROUNDS; i++) {
+        int64_t t0 = now_ns();
+        int64_t t1 = now_ns();
+        __asm__ volatile("" : : "r"(t0), "r"(t1));
+    }
+    return (now_ns() - start) / TIMER_CALIBRATION_ROUNDS / 2;
+}
+
+#define TIME_KERNEL(timings, kernel, call) do {    \
+        int64_t t0_ = now_ns();                     \
+        call;                                       \
+        timings[kernel].total_ns += now_ns() - t0_; \
+        timings[kernel].calls++;                    \
+    } while (0)
+
+static void run_kernel_profile(int variant, long games) {
+    const GameVariant *game_variant = &game_variants[variant];
+    KernelTiming timings[KERNEL_COUNT] = {0};
+    Board board;
+
+    game_seed_random(1);
+
+    for (long i = 0; i < games; i++) {
+        TIME_KERNEL(timings, KERNEL_SETUP_RANDOM_BOARD, setup_random_board(&board, game_variant));
+
+        int game_over = 0;
+        while (!game_over) {
+            int x, y, found, hit, sunk = -1;
+
+            TIME_KERNEL(timings, KERNEL_BOT_CHOOSE_SHOT, found = bot_choose_shot(&board, &x, &y));
+            if (!found) break;
+
+            TIME_KERNEL(timings, KERNEL_CHECK_HIT, hit = check_hit(&board, x, y));
+            if (hit) {
+                TIME_KERNEL(timings, KERNEL_IS_SHIP_SUNK, sunk = is_ship_sunk(&board, x, y));
+                if (sunk != -1) {
+                    TIME_KERNEL(timings, KERNEL_SUNK_THE_SHIP, sunk_the_ship(&board, sunk));
+                }
+            }
+
+            TIME_KERNEL(timings, KERNEL_IS_GAME_OVER, game_over = is_game_over(&board));
+        }
+    }
+
+    int64_t overhead = timer_overhead_ns();
+
+    printf("kernel profile: boards=%ld timer_overhead_ns=%lld dilate=%s\n",
+        games, (long long)overhead, dilate_rows_impl_name());
+    for (int k = 0; k < KERNEL_COUNT; k++) {
+        if (!timings[k].calls) continue;
+
+        double ns_per_call = (double)timings[k].total_ns / timings[k].calls - overhead;
+        if (ns_per_call < 0) ns_per_call = 0;
+
+        printf("  %-20s calls_per_board=%7.2f ns_per_call=%8.1f\n",
+            kernel_names[k], (double)timings[k].calls / games, ns_per_call);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    long games = (argc > 1) ? atol(argv[1]) : DEFAULT_GAMES;
+    long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = (argc > 2) ? atoi(argv[2]) : (cpu_count > 0 ? (int)cpu_count : 1);
+    int variant = (argc > 3) ? find_game_variant(argv[3]) : VARIANT_CLASSIC;
+
+    if (games < 1 || threads < 1 || threads > MAX_THREADS || variant < 0) {
+        fprintf(stderr, "usage: %s [games] [threads <= %d] [classic|quick|large]\n", argv[0], MAX_THREADS);
+        return 1;
+    }
+
+    if (run_throughput(variant, games, threads)) return 1;
+    run_kernel_profile(variant, games < PROFILE_GAMES ? games : PROFILE_GAMES);
+
+    return 0;
+}
@@ -12,7 +12,7 @@
 #include <QDebug>
 
 GameWidget::GameWidget(QNetworkAccessManager *networkManager, QWidget *parent)
-    : QWidget(parent), networkManager(networkManager), webSocket(nullptr), currentPlayerNumber(0), isMyTurn(false) {
+    : QWidget(parent), networkManager(networkManager), webSocket(nullptr), currentPlayerNumber(0), boardSize(10), isMyTurn(false) {
     QVBoxLayout *mainLayout = new QVBoxLayout(this);
 
     statusLabel = new QLabel("Подключение к игре...", this);
@@ -42,9 +42,9 @@ GameWidget::GameWidget(QNetworkAccessManager *networkManager, QWidget *parent)
 void GameWidget::setupBoard(QGridLayout *layout, bool isEnemy) {
     QList<QList<QPushButton*>> &buttons = isEnemy ? enemyBoardButtons : playerBoardButtons;
 
-    for (int row = 0; row < 10; ++row) {
+    for (int row = 0; row < boardSize; ++row) {
         QList<QPushButton*> rowButtons;
-        for (int col = 0; col < 10; ++col) {
+        for (int col = 0; col < boardSize; ++col) {
             QPushButton *button = new QPushButton();
             button->setFixedSize(30, 30);
             button->setProperty("row", row);
@@ -61,14 +61,34 @@ void GameWidget::setupBoard(QGridLayout *layout, bool isEnemy) {
     }
 }
 
-void GameWidget::joinGame(const QString &sessionId, const QString &playerName) {
+void GameWidget::resizeBoards(int size) {
+    for (auto &row : playerBoardButtons) {
+        qDeleteAll(row);
+    }
+    for (auto &row : enemyBoardButtons) {
+        qDeleteAll(row);
+    }
+    playerBoardButtons.clear();
+    enemyBoardButtons.clear();
+
+    boardSize = size;
+    setupBoard(playerBoardLayout, false);
+    setupBoard(enemyBoardLayout, true);
+}
+
+void GameWidget::joinGame(const QString &sessionId, const QString &playerName, const QString &token) {
     leaveGame();
 
     currentSessionId = sessionId;
     currentPlayerName = playerName;
+    currentToken = token;
 
+    // One connection serves every game; the server tags each message with its session_id.
     if (webSocket) {
-        webSocket->deleteLater();
+        if (webSocket->state() == QAbstractSocket::ConnectedState) {
+            sendJoin();
+        }
+        return;
     }
 
     webSocket = new QWebSocket();
@@ -79,24 +99,25 @@ void GameWidget::joinGame(const QString &sessionId, const QString &playerName) {
     webSocket->open(QUrl("ws://localhost:9000"));
 }
 
-void GameWidget::leaveGame() {
-    if (webSocket) {
-        disconnect(webSocket, nullptr, this, nullptr);
-
-        if (webSocket->state() == QAbstractSocket::ConnectedState) {
-            QJsonObject message;
-            message["type"] = "leave";
-            message["session_id"] = currentSessionId;
-            webSocket->sendTextMessage(QJsonDocument(message).toJson());
+void GameWidget::sendJoin() {
+    QJsonObject message;
+    message["type"] = "join";
+    message["session_id"] = currentSessionId;
+    message["token"] = currentToken;
+    webSocket->sendTextMessage(QJsonDocument(message).toJson());
+}
 
-            webSocket->close(QWebSocketProtocol::CloseCodeNormal);
-        }
-        webSocket->deleteLater();
-        webSocket = nullptr;
+void GameWidget::leaveGame() {
+    if (webSocket && !currentSessionId.isEmpty() && webSocket->state() == QAbstractSocket::ConnectedState) {
+        QJsonObject message;
+        message["type"] = "leave";
+        message["session_id"] = currentSessionId;
+        webSocket->sendTextMessage(QJsonDocument(message).toJson());
     }
 
     currentSessionId.clear();
     currentPlayerName.clear();
+    currentToken.clear();
     currentPlayerNumber = 0;
     isMyTurn = false;
 }
@@ -104,18 +125,22 @@ void GameWidget::leaveGame() {
 void GameWidget::onWebSocketConnected() {
     qDebug() << "WebSocket connected";
 
-    QJsonObject message;
-    message["type"] = "join";
-    message["session_id"] = currentSessionId;
-    message["player_name"] = currentPlayerName;
-    webSocket->sendTextMessage(QJsonDocument(message).toJson());
+    if (!currentSessionId.isEmpty()) {
+        sendJoin();
+    }
 
     qDebug() << "Connected";
 }
 
 void GameWidget::onWebSocketDisconnected() {
     qDebug() << "WebSocket disconnected";
-    showGameResult("Соединение с сервером потеряно");
+
+    webSocket->deleteLater();
+    webSocket = nullptr;
+
+    if (!currentSessionId.isEmpty()) {
+        showGameResult("Соединение с сервером потеряно");
+    }
 }
 
 void GameWidget::onWebSocketMessageReceived(const QString &message) {
@@ -124,6 +149,11 @@ void GameWidget::onWebSocketMessageReceived(const QString &message) {
 
     QString type = json["type"].toString();
 
+    // Late messages about a game this widget has already left.
+    if (json.contains("session_id") && json["session_id"].toString() != currentSessionId) {
+        return;
+    }
+
     if (type == "game_state") {
         currentPlayerNumber = json["your_player_number"].toInt();
         isMyTurn = (json["current_player"].toInt() == currentPlayerNumber);
@@ -131,6 +161,10 @@ void GameWidget::onWebSocketMessageReceived(const QString &message) {
         statusLabel->setText(isMyTurn ? "Ваш ход" : "Ход противника");
     } else if (type == "player_left") {
         showGameResult("Партия прервана, игрок вышел");
+    } else if (type == "session_closed") {
+        showGameResult("Сессия закрыта");
+    } else if (type == "seat_taken") {
+        showGameResult("Игра продолжена в другом окне");
     } else if (type == "attack_result") {
         bool game_over = json["game_over"].toBool();
         if (game_over) {
@@ -146,12 +180,17 @@ void GameWidget::onWebSocketMessageReceived(const QString &message) {
 }
 
 void GameWidget::updateBoards(const QJsonObject &gameState) {
+    int size = gameState["board_size"].toInt(10);
+    if (size != boardSize) {
+        resizeBoards(size);
+    }
+
     QJsonObject playerBoard = gameState["player_board"].toObject();
     QJsonArray cells = playerBoard["cells"].toArray();
 
-    for (int row = 0; row < 10; ++row) {
+    for (int row = 0; row < boardSize; ++row) {
         QJsonArray rowCells = cells[row].toArray();
-        for (int col = 0; col < 10; ++col) {
+        for (int col = 0; col < boardSize; ++col) {
             int cellState = rowCells[col].toInt();
             QPushButton *button = playerBoardButtons[row][col];
 
@@ -169,9 +208,9 @@ void GameWidget::updateBoards(const QJsonObject &gameState) {
     QJsonObject enemyBoard = gameState["enemy_board"].toObject();
     cells = enemyBoard["cells"].toArray();
 
-    for (int row = 0; row < 10; ++row) {
+    for (int row = 0; row < boardSize; ++row) {
         QJsonArray rowCells = cells[row].toArray();
-        for (int col = 0; col < 10; ++col) {
+        for (int col = 0; col < boardSize; ++col) {
             int cellState = rowCells[col].toInt();
             QPushButton *button = enemyBoardButtons[row][col];
 
@@ -14,7 +14,7 @@ class GameWidget : public QWidget {
 
 public:
     explicit GameWidget(QNetworkAccessManager *networkManager, QWidget *parent = nullptr);
-    void joinGame(const QString &sessionId, const QString &playerName);
+    void joinGame(const QString &sessionId, const QString &playerName, const QString &token);
     void leaveGame();
 
 signals:
@@ -29,15 +29,19 @@ private slots:
 
 private:
     void setupBoard(QGridLayout *layout, bool isEnemy);
+    void resizeBoards(int size);
     void updateBoards(const QJsonObject &gameState);
     void showGameResult(const QString &result);
     void disableBoards();
+    void sendJoin();
 
     QNetworkAccessManager *networkManager;
     QWebSocket *webSocket;
     QString currentSessionId;
     QString currentPlayerName;
+    QString currentToken;
     int currentPlayerNumber;
+    int boardSize;
     bool isMyTurn;
     bool isGameStarted;
 
@@ -3,8 +3,11 @@
 #include <QHBoxLayout>
 #include <QLineEdit>
 #include <QPushButton>
+#include <QComboBox>
 #include <QListWidget>
 #include <QListWidgetItem>
+#include <QCheckBox>
+#include <QTimer>
 #include <QNetworkReply>
 #include <QJsonDocument>
 #include <QJsonArray>
@@ -13,7 +16,7 @@
 #include <QDateTime>
 
 SessionsListWidget::SessionsListWidget(QNetworkAccessManager *networkManager, QWidget *parent)
-    : QWidget(parent), networkManager(networkManager) {
+    : QWidget(parent), networkManager(networkManager), lobbySocket(nullptr) {
     QVBoxLayout *layout = new QVBoxLayout(this);
 
     playerNameEdit = new QLineEdit(this);
@@ -26,10 +29,29 @@ SessionsListWidget::SessionsListWidget(QNetworkAccessManager *networkManager, QW
     connect(refreshButton, &QPushButton::clicked, this, &SessionsListWidget::onRefreshClicked);
     buttonsLayout->addWidget(refreshButton);
 
+    liveCheckBox = new QCheckBox("Живой список", this);
+    connect(liveCheckBox, &QCheckBox::toggled, this, &SessionsListWidget::onLiveToggled);
+    buttonsLayout->addWidget(liveCheckBox);
+
+    variantCombo = new QComboBox(this);
+    variantCombo->addItem("Классика 10x10", "classic");
+    variantCombo->addItem("Быстрая 8x8", "quick");
+    variantCombo->addItem("Большая 16x16", "large");
+    buttonsLayout->addWidget(variantCombo);
+
     createButton = new QPushButton("Создать сессию", this);
     connect(createButton, &QPushButton::clicked, this, &SessionsListWidget::onCreateClicked);
     buttonsLayout->addWidget(createButton);
 
+    difficultyCombo = new QComboBox(this);
+    difficultyCombo->addItem("Обычный бот", "normal");
+    difficultyCombo->addItem("Сильный бот", "hard");
+    buttonsLayout->addWidget(difficultyCombo);
+
+    playBotButton = new QPushButton("Играть с ботом", this);
+    connect(playBotButton, &QPushButton::clicked, this, &SessionsListWidget::onPlayBotClicked);
+    buttonsLayout->addWidget(playBotButton);
+
     layout->addLayout(buttonsLayout);
 
     sessionsList = new QListWidget(this);
@@ -37,7 +59,8 @@ SessionsListWidget::SessionsListWidget(QNetworkAccessManager *networkManager, QW
     connect(sessionsList, &QListWidget::doubleClicked, this, &SessionsListWidget::onSessionDoubleClicked);
     layout->addWidget(sessionsList);
 
-    refreshSessions();
+    // The server pushes lobby changes over a WebSocket; the initial list comes with the subscription.
+    liveCheckBox->setChecked(true);
 }
 
 void SessionsListWidget::refreshSessions() {
@@ -73,23 +96,7 @@ void SessionsListWidget::onSessionsReceived() {
 
         sessionsList->clear();
         for (const QJsonValue &value : sessions) {
-            QJsonObject session = value.toObject();
-            QString id = session["id"].toString();
-            QString player1 = session["player1"].toString();
-            qint64 createdAt = session["created_at"].toInt();
-
-            QDateTime dt;
-            dt.setSecsSinceEpoch(createdAt);
-            QString timeStr = dt.toString("dd.MM.yyyy HH:mm");
-
-            QListWidgetItem *item = new QListWidgetItem(
-                QString("Сессия: %1\nИгрок: %2\nСоздана: %3")
-                    .arg(id.left(8) + "...")
-                    .arg(player1)
-                    .arg(timeStr)
-                );
-            item->setData(Qt::UserRole, id);
-            sessionsList->addItem(item);
+            addSessionItem(value.toObject());
         }
     } else {
         QMessageBox::critical(this, "Ошибка", "Не удалось получить список сессий");
@@ -98,11 +105,103 @@ void SessionsListWidget::onSessionsReceived() {
     reply->deleteLater();
 }
 
+void SessionsListWidget::addSessionItem(const QJsonObject &session) {
+    QString id = session["id"].toString();
+    removeSessionItem(id);
+
+    QString player1 = session["player1"].toString();
+    qint64 createdAt = session["created_at"].toInt();
+    int boardSize = session["board_size"].toInt(10);
+
+    QDateTime dt;
+    dt.setSecsSinceEpoch(createdAt);
+    QString timeStr = dt.toString("dd.MM.yyyy HH:mm");
+
+    QListWidgetItem *item = new QListWidgetItem(
+        QString("Сессия: %1\nИгрок: %2\nПоле: %3x%3\nСоздана: %4")
+            .arg(id.left(8) + "...")
+            .arg(player1)
+            .arg(boardSize)
+            .arg(timeStr)
+        );
+    item->setData(Qt::UserRole, id);
+    sessionsList->addItem(item);
+}
+
+void SessionsListWidget::removeSessionItem(const QString &sessionId) {
+    for (int i = 0; i < sessionsList->count(); i++) {
+        if (sessionsList->item(i)->data(Qt::UserRole).toString() == sessionId) {
+            delete sessionsList->takeItem(i);
+            return;
+        }
+    }
+}
+
+void SessionsListWidget::onLiveToggled(bool checked) {
+    if (lobbySocket) {
+        disconnect(lobbySocket, nullptr, this, nullptr);
+        lobbySocket->close(QWebSocketProtocol::CloseCodeNormal);
+        lobbySocket->deleteLater();
+        lobbySocket = nullptr;
+    }
+
+    if (!checked) {
+        return;
+    }
+
+    lobbySocket = new QWebSocket();
+    connect(lobbySocket, &QWebSocket::connected, this, &SessionsListWidget::onLobbyConnected);
+    connect(lobbySocket, &QWebSocket::disconnected, this, &SessionsListWidget::onLobbyDisconnected);
+    connect(lobbySocket, &QWebSocket::textMessageReceived, this, &SessionsListWidget::onLobbyMessageReceived);
+
+    lobbySocket->open(QUrl("ws://localhost:9000"));
+}
+
+void SessionsListWidget::onLobbyConnected() {
+    QJsonObject message;
+    message["type"] = "subscribe_lobby";
+    lobbySocket->sendTextMessage(QJsonDocument(message).toJson());
+}
+
+void SessionsListWidget::onLobbyDisconnected() {
+    QTimer::singleShot(3000, this, [this]() {
+        if (liveCheckBox->isChecked()) {
+            onLiveToggled(true);
+        }
+    });
+}
+
+// Events may repeat what the snapshot already showed, so adding and removing are idempotent.
+void SessionsListWidget::onLobbyMessageReceived(const QString &message) {
+    QJsonObject json = QJsonDocument::fromJson(message.toUtf8()).object();
+    QString type = json["type"].toString();
+
+    if (type == "lobby_snapshot") {
+        sessionsList->clear();
+        for (const QJsonValue &value : json["sessions"].toArray()) {
+            addSessionItem(value.toObject());
+        }
+    } else if (type == "lobby_added") {
+        addSessionItem(json["session"].toObject());
+    } else if (type == "lobby_removed") {
+        removeSessionItem(json["id"].toString());
+    }
+}
+
 void SessionsListWidget::onCreateClicked() {
     QString playerName = playerNameEdit->text().trimmed();
     if (playerName.isEmpty()) {
         QMessageBox::warning(this, "Ошибка", "Введите ваше имя");
         return;
     }
-    emit createSessionRequested(playerName);
+    emit createSessionRequested(playerName, variantCombo->currentData().toString(), "human", "normal");
+}
+
+void SessionsListWidget::onPlayBotClicked() {
+    QString playerName = playerNameEdit->text().trimmed();
+    if (playerName.isEmpty()) {
+        QMessageBox::warning(this, "Ошибка", "Введите ваше имя");
+        return;
+    }
+    emit createSessionRequested(playerName, variantCombo->currentData().toString(), "bot", difficultyCombo->currentData().toString());
 }
@@ -3,10 +3,14 @@
 
 #include <QWidget>
 #include <QNetworkAccessManager>
+#include <QWebSocket>
 
 class QLineEdit;
 class QPushButton;
 class QListWidget;
+class QComboBox;
+class QCheckBox;
+class QJsonObject;
 
 class SessionsListWidget : public QWidget {
     Q_OBJECT
@@ -17,20 +21,33 @@ public:
 
 signals:
     void sessionSelected(const QString &sessionId, const QString &playerName);
-    void createSessionRequested(const QString &playerName);
+    void createSessionRequested(const QString &playerName, const QString &variant, const QString &opponent, const QString &difficulty);
 
 private slots:
     void onSessionDoubleClicked(const QModelIndex &index);
     void onRefreshClicked();
     void onCreateClicked();
+    void onPlayBotClicked();
     void onSessionsReceived();
+    void onLiveToggled(bool checked);
+    void onLobbyConnected();
+    void onLobbyDisconnected();
+    void onLobbyMessageReceived(const QString &message);
 
 private:
+    void addSessionItem(const QJsonObject &session);
+    void removeSessionItem(const QString &sessionId);
+
     QNetworkAccessManager *networkManager;
     QLineEdit *playerNameEdit;
     QPushButton *refreshButton;
     QPushButton *createButton;
+    QPushButton *playBotButton;
+    QComboBox *variantCombo;
+    QComboBox *difficultyCombo;
     QListWidget *sessionsList;
+    QCheckBox *liveCheckBox;
+    QWebSocket *lobbySocket;
 };
 
 #endif // SESSIONSLISTWIDGET_H
@@ -32,15 +32,18 @@ MainWindow::MainWindow(QWidget *parent)
 MainWindow::~MainWindow() {
 }
 
-void MainWindow::showGameWidget(const QString &sessionId, const QString &playerName) {
+void MainWindow::showGameWidget(const QString &sessionId, const QString &playerName, const QString &token) {
     gameWidget->leaveGame();
-    gameWidget->joinGame(sessionId, playerName);
+    gameWidget->joinGame(sessionId, playerName, token);
     stackedWidget->setCurrentIndex(1);
 }
 
-void MainWindow::handleCreateSession(const QString &playerName) {
+void MainWindow::handleCreateSession(const QString &playerName, const QString &variant, const QString &opponent, const QString &difficulty) {
     QJsonObject json;
     json["player_name"] = playerName;
+    json["variant"] = variant;
+    json["opponent"] = opponent;
+    json["difficulty"] = difficulty;
 
     QNetworkRequest request(QUrl("http://localhost:8080/create"));
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
@@ -54,7 +57,8 @@ void MainWindow::handleCreateSession(const QString &playerName) {
             QJsonObject json = doc.object();
 
             QString sessionId = json["session_id"].toString();
-            showGameWidget(sessionId, playerName);
+            QString token = json["token"].toString();
+            showGameWidget(sessionId, playerName, token);
         } else {
             QMessageBox::critical(this, "Ошибка", "Не удалось создать сессию: " + reply->errorString());
         }
@@ -78,7 +82,7 @@ void MainWindow::handleJoinSession(const QString &sessionId, const QString &play
             QJsonDocument doc = QJsonDocument::fromJson(response);
             QJsonObject json = doc.object();
 
-            showGameWidget(sessionId, playerName);
+            showGameWidget(sessionId, playerName, json["token"].toString());
         } else {
             QMessageBox::critical(this, "Ошибка", "Не удалось подключиться к сессии: " + reply->errorString());
         }
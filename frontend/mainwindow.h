@@ -16,8 +16,8 @@ public:
     ~MainWindow();
 
 private slots:
-    void showGameWidget(const QString &sessionId, const QString &playerName);
-    void handleCreateSession(const QString &playerName);
+    void showGameWidget(const QString &sessionId, const QString &playerName, const QString &token);
+    void handleCreateSession(const QString &playerName, const QString &variant, const QString &opponent, const QString &difficulty);
     void handleJoinSession(const QString &sessionId, const QString &playerName);
 
 private: